@@ -21,6 +21,10 @@
 
 #include <string.h>
 
+#if KEM_DEGREE != N
+#error KEM_DEGREE does not match the compiled parameter set.
+#endif
+
 /* ====================================================================== */
 
 /*
@@ -661,20 +665,63 @@ Zn(encap_seed)(void *secret, size_t secret_len,
 	}
 }
 
+/* see api.h */
+int
+Zn(encap_ctx)(void *secret, size_t secret_len,
+	Zn(ct) *ct, const Zn(pk) *pk, prng *ctx)
+{
+	uint8_t m[LVLBYTES];
+
+	randombytes_ctx(ctx, m, sizeof m);
+	return Zn(encap_seed)(secret, secret_len, ct, pk, m);
+}
+
+/* see api.h */
+void
+Zn(prepare_sk)(Zn(sk_prepared) *prepared, const Zn(sk) *sk)
+{
+	uint8_t seed[SEED_BYTES];
+
+	Zn(decode_sk)(
+		seed, prepared->rr,
+		prepared->f, prepared->g, prepared->F, prepared->G,
+		prepared->h, prepared->w,
+		sk->sk, KEM_SECRETKEY_BYTES);
+}
+
+/* see api.h */
+void
+Zn(sk_prepared_release)(Zn(sk_prepared) *prepared)
+{
+	volatile uint8_t *p;
+	size_t u;
+
+	p = (volatile uint8_t *)prepared;
+	for (u = 0; u < sizeof *prepared; u ++) {
+		p[u] = 0;
+	}
+}
+
 /* see api.h */
 int
 Zn(decap)(void *secret, size_t secret_len,
 	const Zn(ct) *ct, const Zn(sk) *sk)
+{
+	Zn(sk_prepared) prepared;
+	int r;
+
+	Zn(prepare_sk)(&prepared, sk);
+	r = Zn(decap_prepared)(secret, secret_len, ct, &prepared);
+	Zn(sk_prepared_release)(&prepared);
+	return r;
+}
+
+/* see api.h */
+int
+Zn(decap_prepared)(void *secret, size_t secret_len,
+	const Zn(ct) *ct, const Zn(sk_prepared) *sk)
 {
     __attribute__((aligned(8))) uint8_t tmp[ZN(TMP_DECAPS)];
-    int8_t f[N];
-    int8_t g[N];
-    int8_t F[N];
-    int8_t G[N];
-    int32_t w[N];
-    uint16_t h[N];
-    uint8_t rr[SEED_BYTES];
-    uint8_t seed[SEED_BYTES];
 	uint8_t sbuf[SBUF_LEN(LOGN)], m[LVLBYTES], m_alt[LVLBYTES];
 	uint8_t sbuf_alt[SBUF_LEN(LOGN)];
 	int8_t c[N];
@@ -683,19 +730,13 @@ Zn(decap)(void *secret, size_t secret_len,
 	size_t u;
 	uint32_t d;
 
-    Zn(decode_sk)(
-            seed, rr,
-            f, g, F, G,
-            h, w,
-            sk->sk, KEM_SECRETKEY_BYTES);
-
 	Zn(decode_ct)(c, c2, ct->ct, KEM_CIPHERTXT_BYTES);
 
 	/*
 	 * Inner decryption never fails (at least, it never reports
 	 * a failure).
 	 */
-	XCAT(bat_decrypt_, Q)(sbuf, c, f, g, F, G, w, LOGN, (uint32_t*)tmp);
+	XCAT(bat_decrypt_, Q)(sbuf, c, sk->f, sk->g, sk->F, sk->G, sk->w, LOGN, (uint32_t*)tmp);
 
 	/*
 	 * From sbuf, we derive the mask that allows recovery of m
@@ -716,7 +757,7 @@ Zn(decap)(void *secret, size_t secret_len,
 	sbuf_alt[0] &= (1u << N) - 1u;
 #endif
 	c_alt = (int8_t*)tmp;
-	d = XCAT(bat_encrypt_, Q)(c_alt, sbuf_alt, h, LOGN, (uint32_t*)tmp);
+	d = XCAT(bat_encrypt_, Q)(c_alt, sbuf_alt, sk->h, LOGN, (uint32_t*)tmp);
 	d --;
 	for (u = 0; u < sizeof sbuf; u ++) {
 		d |= sbuf[u] ^ sbuf_alt[u];
@@ -735,7 +776,7 @@ Zn(decap)(void *secret, size_t secret_len,
 	 * both hashes and perform constant-time conditional replacement.
 	 */
 
-	make_kdf_seed_bad(m_alt, sizeof m, rr, ct);
+	make_kdf_seed_bad(m_alt, sizeof m, sk->rr, ct);
 	d = -((uint32_t)(d | -d) >> 31);
 	for (u = 0; u < sizeof m; u ++) {
 		m[u] ^= d & (m[u] ^ m_alt[u]);
@@ -6,6 +6,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "randombytes.h"
+
 // 1 (TAGBYTE) + N / 64 * 65 (encode_257)
 #define KEM_PUBLICKEY_BYTES 521
 // 1 (TAGBYTE) + N / 64 * 57 (encode_ciphtertext_257) + 16 (C2_BYTES)
@@ -14,6 +16,9 @@
 #define KEM_SECRETKEY_BYTES 2953
 #define KEM_SHORTSECRETKEY_BYTES 417
 
+// N of BAT_257_512, for the decoded key in kem_sk_prepared.
+#define KEM_DEGREE 512
+
 #define C2_BYTES 16
 #define SEED_BYTES 32
 
@@ -29,14 +34,35 @@ typedef struct {
     uint8_t ct[KEM_CIPHERTXT_BYTES];
 } kem_ct;
 
+// kem_sk decoded once, for decapsulating many ciphertexts under one key.
+typedef struct {
+    int8_t f[KEM_DEGREE];
+    int8_t g[KEM_DEGREE];
+    int8_t F[KEM_DEGREE];
+    int8_t G[KEM_DEGREE];
+    int32_t w[KEM_DEGREE];
+    uint16_t h[KEM_DEGREE];
+    uint8_t rr[SEED_BYTES];
+} kem_sk_prepared;
+
 int kem_keygen(kem_sk *sk, kem_pk *pk);
 
 int kem_encap(
     void *secret, size_t secret_len, kem_ct *ct,
     const kem_pk *pk);
+// kem_encap with its message drawn from ctx instead of the system.
+int kem_encap_ctx(
+    void *secret, size_t secret_len, kem_ct *ct,
+    const kem_pk *pk, prng *ctx);
 int kem_decap(
     void *secret, size_t secret_len, const kem_ct *ct,
     const kem_sk *sk);
 
+void kem_prepare_sk(kem_sk_prepared *prepared, const kem_sk *sk);
+int kem_decap_prepared(
+    void *secret, size_t secret_len, const kem_ct *ct,
+    const kem_sk_prepared *sk);
+void kem_sk_prepared_release(kem_sk_prepared *prepared);
+
 #endif
 
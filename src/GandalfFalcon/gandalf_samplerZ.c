@@ -8,6 +8,34 @@
 
 #include "samplerZ_table.c"
 
+/* Define GANDALF_SAMPLERZ_AVX2 to 0 in order to disable the AVX2 engine.
+   The engine is gated at runtime on CPU support. */
+#ifndef GANDALF_SAMPLERZ_AVX2
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define GANDALF_SAMPLERZ_AVX2   1
+#else
+#define GANDALF_SAMPLERZ_AVX2   0
+#endif
+#endif
+
+/* Define GANDALF_SAMPLERZ_NEON to 1 on aarch64 to enable the NEON engine. It
+   is off by default until it has been built and tested on an aarch64 target. */
+#ifndef GANDALF_SAMPLERZ_NEON
+#define GANDALF_SAMPLERZ_NEON   0
+#endif
+#if GANDALF_SAMPLERZ_NEON && !(defined __aarch64__ && defined __ARM_NEON)
+#error "GANDALF_SAMPLERZ_NEON needs an aarch64 target with NEON"
+#endif
+
+#if GANDALF_SAMPLERZ_AVX2
+#include <immintrin.h>
+#define TARGET_SAMPLERZ_AVX2   __attribute__((target("avx2")))
+#endif
+
+#if GANDALF_SAMPLERZ_NEON
+#include <arm_neon.h>
+#endif
+
 int32_t Gandalf_Gaussian_sampler(){
 
     uint64_t zero_mask, neg_mask, r;
@@ -38,7 +66,182 @@ int32_t Gandalf_Gaussian_sampler(){
 
 }
 
+// The batch engines below compute, for GANDALF_SAMPLER_BATCH values r[j],
+//     z[j] = 1 + #{ 1 <= i < GANDALF_TABLE_SIZE : r[j] >= Gandalf_table[i] }
+// which is the magnitude computed by Gandalf_Gaussian_sampler.
+// Each table entry is loaded once per batch and compared against all lanes;
+// every entry is read for every batch, so the access pattern is independent
+// of the samples.
+
+// Four lanes at a time keep the counters in registers.
+static
+void Gandalf_cdt_batch_portable(int32_t *z, const uint64_t *r){
+
+    uint64_t t;
+    uint32_t z0, z1, z2, z3;
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j += 4){
+        z0 = z1 = z2 = z3 = 1;
+        for(size_t i = 1; i < GANDALF_TABLE_SIZE; i++){
+            t = Gandalf_table[i];
+            z0 += (r[j + 0] >= t);
+            z1 += (r[j + 1] >= t);
+            z2 += (r[j + 2] >= t);
+            z3 += (r[j + 3] >= t);
+        }
+        z[j + 0] = (int32_t)z0;
+        z[j + 1] = (int32_t)z1;
+        z[j + 2] = (int32_t)z2;
+        z[j + 3] = (int32_t)z3;
+    }
+
+}
+
+#if GANDALF_SAMPLERZ_AVX2
+
+// AVX2 has no unsigned 64-bit comparison; both sides are biased by 2^63 so
+// that the signed comparison gives the unsigned order. Each lane accumulates
+// -1 for every entry strictly above r, hence
+//     z = 1 + (GANDALF_TABLE_SIZE - 1) - #{ t > r } = GANDALF_TABLE_SIZE + acc.
+TARGET_SAMPLERZ_AVX2
+static
+void Gandalf_cdt_batch_avx2(int32_t *z, const uint64_t *r){
+
+    __m256i bias, t, r0, r1, r2, r3, a0, a1, a2, a3;
+    int64_t acc[GANDALF_SAMPLER_BATCH];
+
+    bias = _mm256_set1_epi64x(INT64_MIN);
+    r0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(r +  0)), bias);
+    r1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(r +  4)), bias);
+    r2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(r +  8)), bias);
+    r3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(r + 12)), bias);
+    a0 = _mm256_setzero_si256();
+    a1 = _mm256_setzero_si256();
+    a2 = _mm256_setzero_si256();
+    a3 = _mm256_setzero_si256();
+
+    for(size_t i = 1; i < GANDALF_TABLE_SIZE; i++){
+        t = _mm256_xor_si256(_mm256_set1_epi64x((int64_t)Gandalf_table[i]), bias);
+        a0 = _mm256_add_epi64(a0, _mm256_cmpgt_epi64(t, r0));
+        a1 = _mm256_add_epi64(a1, _mm256_cmpgt_epi64(t, r1));
+        a2 = _mm256_add_epi64(a2, _mm256_cmpgt_epi64(t, r2));
+        a3 = _mm256_add_epi64(a3, _mm256_cmpgt_epi64(t, r3));
+    }
+
+    _mm256_storeu_si256((__m256i*)(acc +  0), a0);
+    _mm256_storeu_si256((__m256i*)(acc +  4), a1);
+    _mm256_storeu_si256((__m256i*)(acc +  8), a2);
+    _mm256_storeu_si256((__m256i*)(acc + 12), a3);
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        z[j] = (int32_t)(GANDALF_TABLE_SIZE + acc[j]);
+    }
+
+}
+
+#endif
+
+#if GANDALF_SAMPLERZ_NEON
+
+// vcgeq_u64 gives all-ones for r >= t; subtracting it counts the entries.
+static
+void Gandalf_cdt_batch_neon(int32_t *z, const uint64_t *r){
+
+    uint64x2_t t, rv[GANDALF_SAMPLER_BATCH / 2], acc[GANDALF_SAMPLER_BATCH / 2];
+    uint64_t out[GANDALF_SAMPLER_BATCH];
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH / 2; j++){
+        rv[j] = vld1q_u64(r + 2 * j);
+        acc[j] = vdupq_n_u64(1);
+    }
+
+    for(size_t i = 1; i < GANDALF_TABLE_SIZE; i++){
+        t = vdupq_n_u64(Gandalf_table[i]);
+        for(size_t j = 0; j < GANDALF_SAMPLER_BATCH / 2; j++){
+            acc[j] = vsubq_u64(acc[j], vcgeq_u64(rv[j], t));
+        }
+    }
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH / 2; j++){
+        vst1q_u64(out + 2 * j, acc[j]);
+    }
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        z[j] = (int32_t)out[j];
+    }
+
+}
+
+#endif
+
+#if GANDALF_SAMPLERZ_AVX2
+// CPU support for AVX2, looked up once when the library is loaded.
+static int samplerZ_use_avx2;
+
+__attribute__((constructor))
+static void samplerZ_simd_init(void){
+    __builtin_cpu_init();
+    samplerZ_use_avx2 = __builtin_cpu_supports("avx2");
+}
+#endif
+
+// Same randomness consumption as GANDALF_SAMPLER_BATCH successive calls to
+// Gandalf_Gaussian_sampler, hence the same output for the same PRNG state.
+static
+void Gandalf_Gaussian_sampler_batch(int32_t *z){
+
+    uint64_t rnd[2 * GANDALF_SAMPLER_BATCH];
+    uint64_t zero_mask[GANDALF_SAMPLER_BATCH], r[GANDALF_SAMPLER_BATCH];
+    uint64_t neg_mask, zm;
+    int32_t v;
+
+    get64_bulk(rnd, 2 * GANDALF_SAMPLER_BATCH);
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        zero_mask[j] = rnd[2 * j];
+        r[j] = rnd[2 * j + 1];
+    }
+
+#if GANDALF_SAMPLERZ_AVX2
+    if(samplerZ_use_avx2){
+        Gandalf_cdt_batch_avx2(z, r);
+    }else{
+        Gandalf_cdt_batch_portable(z, r);
+    }
+#elif GANDALF_SAMPLERZ_NEON
+    Gandalf_cdt_batch_neon(z, r);
+#else
+    Gandalf_cdt_batch_portable(z, r);
+#endif
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        neg_mask = -(zero_mask[j] >> 63);
+        zm = zero_mask[j] & ((1ULL << 63) - 1);
+        zm = ((zm - Gandalf_table[0]) >> 63) & 1;
+        zm = ~(-zm);
+        v = z[j];
+        v = ( v & (~neg_mask) ) | ( (-v) & (neg_mask) );
+        z[j] = zm & v;
+    }
+
+}
+
+#if N % GANDALF_SAMPLER_BATCH != 0
+#error "N must be a multiple of GANDALF_SAMPLER_BATCH"
+#endif
+
 void Gandalf_sample_poly(poly *u){
+
+    int32_t z[GANDALF_SAMPLER_BATCH];
+
+    for(size_t i = 0; i < N; i += GANDALF_SAMPLER_BATCH){
+        Gandalf_Gaussian_sampler_batch(z);
+        for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+            u->coeffs[i + j] = z[j];
+        }
+    }
+
+}
+
+void Gandalf_sample_poly_ref(poly *u){
     for(size_t i = 0; i < N; i++){
         u->coeffs[i] = Gandalf_Gaussian_sampler();
     }
@@ -30,3 +30,24 @@ void hash_to_poly(poly *out, shake128incctx *state){
 
 }
 
+void hash_ring_init(shake128incctx *state){
+
+  const uint8_t version = RSIG_SIGNATURE_VERSION;
+
+  shake128_inc_init(state);
+  shake128_inc_absorb(state, &version, 1);
+
+}
+
+void hash_ring_to_poly(poly *out, const shake128incctx *ring_state,
+        const uint8_t *m, const size_t mlen, const uint8_t *salt){
+
+  shake128incctx state;
+
+  shake128_inc_ctx_clone(&state, ring_state);
+  shake128_inc_absorb(&state, m, mlen);
+  shake128_inc_absorb(&state, salt, SALT_BYTES);
+  shake128_inc_finalize(&state);
+  hash_to_poly(out, &state);
+
+}
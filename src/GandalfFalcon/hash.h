@@ -10,5 +10,13 @@
 // We only accept elements smaller than Q here.
 void hash_to_poly(poly *out, shake128incctx *state);
 
+// Starts the hash of a ring by absorbing RSIG_SIGNATURE_VERSION; the
+// caller then absorbs the ring public key.
+void hash_ring_init(shake128incctx *state);
+// out = H(version || pks || m || salt), continuing from a clone of the
+// ring state so that ring_state can be reused.
+void hash_ring_to_poly(poly *out, const shake128incctx *ring_state,
+        const uint8_t *m, const size_t mlen, const uint8_t *salt);
+
 #endif
 
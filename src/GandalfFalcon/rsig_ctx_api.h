@@ -0,0 +1,15 @@
+#ifndef RSIG_CTX_API_H
+#define RSIG_CTX_API_H
+
+#include "rsig_api.h"
+#include "randombytes.h"
+
+// sign_keygen and Gandalf_sign drawing their randomness from ctx instead of
+// the calling thread's context, which is left as it was. Kept apart from
+// rsig_api.h so that rng.h stays out of the headers the Falcon signing
+// code (and its test harnesses) include.
+void sign_keygen_ctx(sign_sk *sk, sign_pk *pk, prng *ctx);
+void Gandalf_sign_ctx(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
+    const sign_sk *sk, size_t party_id, prng *ctx);
+
+#endif
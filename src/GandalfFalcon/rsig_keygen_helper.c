@@ -9,9 +9,9 @@
 
 #include "pack_unpack.h"
 
-void sign_keygen(sign_sk *sk, sign_pk *pk) {
-
-    uint8_t seed[32];
+// Everything after drawing the seed, which is the only randomness of keygen.
+static
+void sign_keygen_seed(sign_sk *sk, sign_pk *pk, const uint8_t seed[32]) {
 
     int8_t f[N], g[N];
     uint16_t h[N];
@@ -20,8 +20,6 @@ void sign_keygen(sign_sk *sk, sign_pk *pk) {
     poly f_poly, g_poly, h_poly;
     poly buff_poly;
 
-    randombytes(seed, 32);
-
     shake_context pc;
     shake_init(&pc, 256);
     shake_inject(&pc, seed, 32);
@@ -85,6 +83,20 @@ void sign_keygen(sign_sk *sk, sign_pk *pk) {
 
 }
 
+void sign_keygen(sign_sk *sk, sign_pk *pk) {
 
+    uint8_t seed[32];
 
+    randombytes(seed, 32);
+    sign_keygen_seed(sk, pk, seed);
 
+}
+
+void sign_keygen_ctx(sign_sk *sk, sign_pk *pk, prng *ctx) {
+
+    uint8_t seed[32];
+
+    randombytes_ctx(ctx, seed, 32);
+    sign_keygen_seed(sk, pk, seed);
+
+}
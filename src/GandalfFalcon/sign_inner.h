@@ -672,6 +672,47 @@ trapdoor_sampler(unsigned logn,
 #define check_norm fndsa_check_norm
 int check_norm(const size_t logn, int16_t *s1, int16_t *s2);
 
+/* Number of fpr slots in the LDL tree of a degree-2^logn Gram matrix:
+   l10 (n slots), then the right sub-tree (from d11), then the left
+   sub-tree (from d00); a leaf (logn = 1) holds g01, g00 and g11 in 4
+   slots. */
+#define FFLDL_TREE_SIZE(logn)   ((((size_t)(logn)) + 1) << (logn))
+
+/* Build the LDL tree of the Gram matrix [[g00, g01], [adj(g01), g11]]
+   (FFT representation, g00 and g11 self-adjoint) into tree[], with the
+   layout ffsamp_tree() expects. g01 and g11 are consumed. tmp[] must
+   have room for 2*n fpr slots. */
+#define ffLDL_tree   fndsa_ffLDL_tree
+void ffLDL_tree(unsigned logn, fpr *tree,
+	const fpr *g00, fpr *g01, fpr *g11, fpr *tmp);
+
+/* Same as ffsamp_fft(), with the LDL decompositions read from a tree
+   built by ffLDL_tree() instead of being recomputed. tmp[] contains the
+   target [t0, t1] (2*n slots) followed by 2*n free slots; the sampled
+   vector is written over [t0, t1]. */
+#define ffsamp_tree   fndsa_ffsamp_tree
+void ffsamp_tree(sampler_state *ss, const fpr *tree, fpr *tmp);
+
+/* Compute the lattice basis [[g, -f], [G, -F]] in FFT representation
+   (b00, b01, b10, b11) and the LDL tree of its Gram matrix
+   (FFLDL_TREE_SIZE(logn) slots), for use with
+   trapdoor_sampler_expanded(). tmp[] must have room for 5*n fpr slots. */
+#define expand_trapdoor_key   fndsa_expand_trapdoor_key
+void expand_trapdoor_key(unsigned logn,
+	fpr *b00, fpr *b01, fpr *b10, fpr *b11, fpr *tree,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	void *tmp);
+
+/* Same output as trapdoor_sampler() for the same subseed, on a key
+   expanded by expand_trapdoor_key(). tmp[] must have room for 4*n fpr
+   slots. */
+#define trapdoor_sampler_expanded   fndsa_trapdoor_sampler_expanded
+void trapdoor_sampler_expanded(unsigned logn,
+	int16_t *s1, int16_t *s2,
+	const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+	const fpr *tree, const uint16_t *c, const uint8_t *subseed,
+	void *tmp);
+
 /* Internal signing function. The complete signing key (encoded for f,
    g and F, but skipping the leading header byte, and decoded for G) is
    provided, as well as the hashed verifying key, data to sign (context,
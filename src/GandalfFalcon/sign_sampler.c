@@ -1335,3 +1335,96 @@ ffsamp_fft(sampler_state *ss, fpr *tmp)
 {
 	ffsamp_fft_inner(ss, ss->logn, tmp);
 }
+
+/* see sign_inner.h */
+void
+ffLDL_tree(unsigned logn, fpr *tree,
+	const fpr *g00, fpr *g01, fpr *g11, fpr *tmp)
+{
+	if (logn == 1) {
+		/* Leaf: keep the Gram matrix itself, in the order used by
+		   ffsamp_fft_deepest(). */
+		tree[0] = g01[0];
+		tree[1] = g01[1];
+		tree[2] = g00[0];
+		tree[3] = g11[0];
+		return;
+	}
+
+	size_t n = (size_t)1 << logn;
+	size_t hn = n >> 1;
+	size_t qn = hn >> 1;
+
+	/* Same steps as ffsamp_fft_inner(): decompose G into LDL, then
+	   split d11 (right sub-tree) and d00 (left sub-tree). The
+	   half-size Gram matrices are built in tmp[]:
+	      0..hn-1         sub_01
+	      hn..hn+qn-1     sub_00 (the split writes hn slots here)
+	      hn+qn..n-1      sub_11 (copy of sub_00)
+	      n..2n-1         scratch for the recursive call */
+	fpr *sub_01 = tmp;
+	fpr *sub_00 = tmp + hn;
+	fpr *sub_11 = tmp + hn + qn;
+
+	fpoly_LDL_fft(logn, g00, g01, g11);
+	memcpy(tree, g01, n * sizeof(fpr));
+
+	fpoly_split_selfadj_fft(logn, sub_00, sub_01, g11);
+	memcpy(sub_11, sub_00, qn * sizeof(fpr));
+	ffLDL_tree(logn - 1, tree + n, sub_00, sub_01, sub_11, tmp + n);
+
+	fpoly_split_selfadj_fft(logn, sub_00, sub_01, g00);
+	memcpy(sub_11, sub_00, qn * sizeof(fpr));
+	ffLDL_tree(logn - 1, tree + n + FFLDL_TREE_SIZE(logn - 1),
+		sub_00, sub_01, sub_11, tmp + n);
+}
+
+TARGET_SSE2 TARGET_NEON
+static void
+ffsamp_tree_inner(sampler_state *ss, unsigned logn, const fpr *tree, fpr *tmp)
+{
+	if (logn == 1) {
+		memcpy(tmp + 4, tree, 4 * sizeof(fpr));
+		ffsamp_fft_deepest(ss, tmp);
+		return;
+	}
+
+	size_t n = (size_t)1 << logn;
+	size_t hn = n >> 1;
+
+	/* Layout:
+	      0..n-1      t0
+	      n..2n-1     t1
+	      2n..4n-1    callee input and scratch; z1 goes to 3n..4n-1
+	                  once the first recursive call has returned.
+	   The operations are those of ffsamp_fft_inner(), in the same
+	   order, so that the output is identical. */
+	const fpr *l10 = tree;
+	const fpr *right = tree + n;
+	const fpr *left = right + FFLDL_TREE_SIZE(logn - 1);
+	fpr *t0 = tmp;
+	fpr *t1 = tmp + n;
+	fpr *sub = tmp + (n << 1);
+	fpr *z1 = sub + n;
+
+	fpoly_split_fft(logn, sub, sub + hn, t1);
+	ffsamp_tree_inner(ss, logn - 1, right, sub);
+	fpoly_merge_fft(logn, z1, sub, sub + hn);
+
+	/* tb0 = t0 + (t1 - z1)*l10 (into t0), and z1 moves into t1. */
+	fpoly_sub(logn, t1, z1);
+	fpoly_mul_fft(logn, t1, l10);
+	fpoly_add(logn, t0, t1);
+	memcpy(t1, z1, n * sizeof(fpr));
+
+	fpoly_split_fft(logn, sub, sub + hn, t0);
+	ffsamp_tree_inner(ss, logn - 1, left, sub);
+	fpoly_merge_fft(logn, t0, sub, sub + hn);
+}
+
+/* see sign_inner.h */
+void
+ffsamp_tree(sampler_state *ss, const fpr *tree, fpr *tmp)
+{
+	ffsamp_tree_inner(ss, ss->logn, tree, tmp);
+}
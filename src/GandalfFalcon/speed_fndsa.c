@@ -83,6 +83,8 @@
 #include <string.h>
 
 #include "fndsa.h"
+#include "gandalf_samplerZ.h"
+#include "randombytes.h"
 
 #if defined __x86_64__ || defined _M_X64 || defined __i386__ || defined _M_IX86
 #include <immintrin.h>
@@ -233,6 +235,29 @@ bench_verify(unsigned logn, unsigned *x)
 	return (double)tt[50];
 }
 
+static double
+bench_gandalf_sample_poly(int ref, unsigned *x)
+{
+	poly u;
+	uint64_t tt[100];
+	init_prng();
+	for (int i = 0; i < 120; i ++) {
+		uint64_t begin = core_cycles();
+		if (ref) {
+			Gandalf_sample_poly_ref(&u);
+		} else {
+			Gandalf_sample_poly(&u);
+		}
+		uint64_t end = core_cycles();
+		if (i >= 20) {
+			tt[i - 20] = end - begin;
+		}
+		*x ^= (unsigned)u.coeffs[i];
+	}
+	qsort(tt, 100, sizeof(uint64_t), &cmp_u64);
+	return (double)tt[50];
+}
+
 int
 main(void)
 {
@@ -245,6 +270,11 @@ main(void)
 	printf("FN-DSA verify (n = 512)        %13.2f\n", bench_verify(9, &x));
 	printf("FN-DSA verify (n = 1024)       %13.2f\n", bench_verify(10, &x));
 
+	printf("Gandalf sample_poly            %13.2f\n",
+		bench_gandalf_sample_poly(0, &x));
+	printf("Gandalf sample_poly (ref)      %13.2f\n",
+		bench_gandalf_sample_poly(1, &x));
+
 	printf("%u\n", x);
 	return 0;
 }
@@ -62,6 +62,10 @@ test_prng_next_u64(test_rng_context *pc)
 #define ffsamp_fft           test_ffsamp_fft
 #undef ffsamp_fft_deepest
 #define ffsamp_fft_deepest   test_ffsamp_fft_deepest
+#undef ffLDL_tree
+#define ffLDL_tree           test_ffLDL_tree
+#undef ffsamp_tree
+#define ffsamp_tree          test_ffsamp_tree
 
 #include "sign_sampler.c"
 
@@ -176,11 +176,19 @@ chacha20rng_next_u64(chacha20rng_context *pc)
 #define ffsamp_fft           chacha20_ffsamp_fft
 #undef ffsamp_fft_deepest
 #define ffsamp_fft_deepest   chacha20_ffsamp_fft_deepest
+#undef ffLDL_tree
+#define ffLDL_tree           chacha20_ffLDL_tree
+#undef ffsamp_tree
+#define ffsamp_tree          chacha20_ffsamp_tree
 
 #undef trapdoor_sampler
 #define trapdoor_sampler chacha20_trapdoor_sampler
 #undef check_norm
 #define check_norm chacha20_check_norm
+#undef expand_trapdoor_key
+#define expand_trapdoor_key chacha20_expand_trapdoor_key
+#undef trapdoor_sampler_expanded
+#define trapdoor_sampler_expanded chacha20_trapdoor_sampler_expanded
 
 #include "sign_sampler.c"
 
@@ -38,7 +38,85 @@ int32_t Gandalf_Gaussian_sampler(){
 
 }
 
+// The batch engine below computes, for GANDALF_SAMPLER_BATCH values r[j],
+//     z[j] = 1 + #{ 1 <= i < GANDALF_TABLE_SIZE : r[j] >= Gandalf_table[i] }
+// which is the magnitude computed by Gandalf_Gaussian_sampler.
+// Each table entry is loaded once per batch and compared against all lanes;
+// every entry is read for every batch, so the access pattern is independent
+// of the samples.
+
+// Four lanes at a time keep the counters in registers.
+static
+void Gandalf_cdt_batch_portable(int32_t *z, const uint64_t *r){
+
+    uint64_t t;
+    uint32_t z0, z1, z2, z3;
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j += 4){
+        z0 = z1 = z2 = z3 = 1;
+        for(size_t i = 1; i < GANDALF_TABLE_SIZE; i++){
+            t = Gandalf_table[i];
+            z0 += (r[j + 0] >= t);
+            z1 += (r[j + 1] >= t);
+            z2 += (r[j + 2] >= t);
+            z3 += (r[j + 3] >= t);
+        }
+        z[j + 0] = (int32_t)z0;
+        z[j + 1] = (int32_t)z1;
+        z[j + 2] = (int32_t)z2;
+        z[j + 3] = (int32_t)z3;
+    }
+
+}
+
+// Same randomness consumption as GANDALF_SAMPLER_BATCH successive calls to
+// Gandalf_Gaussian_sampler, hence the same output for the same PRNG state.
+static
+void Gandalf_Gaussian_sampler_batch(int32_t *z){
+
+    uint64_t rnd[2 * GANDALF_SAMPLER_BATCH];
+    uint64_t zero_mask[GANDALF_SAMPLER_BATCH], r[GANDALF_SAMPLER_BATCH];
+    uint64_t neg_mask, zm;
+    int32_t v;
+
+    get64_bulk(rnd, 2 * GANDALF_SAMPLER_BATCH);
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        zero_mask[j] = rnd[2 * j];
+        r[j] = rnd[2 * j + 1];
+    }
+
+    Gandalf_cdt_batch_portable(z, r);
+
+    for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+        neg_mask = -(zero_mask[j] >> 63);
+        zm = zero_mask[j] & ((1ULL << 63) - 1);
+        zm = ((zm - Gandalf_table[0]) >> 63) & 1;
+        zm = ~(-zm);
+        v = z[j];
+        v = ( v & (~neg_mask) ) | ( (-v) & (neg_mask) );
+        z[j] = zm & v;
+    }
+
+}
+
+#if N % GANDALF_SAMPLER_BATCH != 0
+#error "N must be a multiple of GANDALF_SAMPLER_BATCH"
+#endif
+
 void Gandalf_sample_poly(poly *u){
+
+    int32_t z[GANDALF_SAMPLER_BATCH];
+
+    for(size_t i = 0; i < N; i += GANDALF_SAMPLER_BATCH){
+        Gandalf_Gaussian_sampler_batch(z);
+        for(size_t j = 0; j < GANDALF_SAMPLER_BATCH; j++){
+            u->coeffs[i + j] = z[j];
+        }
+    }
+
+}
+
+void Gandalf_sample_poly_ref(poly *u){
     for(size_t i = 0; i < N; i++){
         u->coeffs[i] = Gandalf_Gaussian_sampler();
     }
@@ -6,12 +6,16 @@
 #include <stdint.h>
 
 #define GANDALF_TABLE_SIZE (1308)
+// Number of coefficients sampled per pass over Gandalf_table.
+#define GANDALF_SAMPLER_BATCH (16)
 
 extern
 uint64_t Gandalf_table[GANDALF_TABLE_SIZE];
 
 int32_t Gandalf_Gaussian_sampler();
 void Gandalf_sample_poly(poly *u);
+// Coefficient-by-coefficient reference for Gandalf_sample_poly.
+void Gandalf_sample_poly_ref(poly *u);
 
 #endif
 
@@ -481,6 +481,35 @@ void poly_mul(poly *des, const poly *src1, const poly *src2){
 
 }
 
+void poly_NTT(poly *src){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+    poly_NTT_montgomery_generic(src, CT_NTT_twiddle_Rmod_table, data);
+}
+
+void poly_iNTT(poly *src){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+    poly_iNTT_montgomery_generic(src, GS_iNTT_twiddle_Rmod_table, data);
+}
+
+void poly_point_mul(poly *des, const poly *src1, const poly *src2){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+    poly_point_mul_generic(des, src1, src2, data);
+}
+
+void poly_mul_NTT(poly *des, const poly *src1, const poly *src2_NTT){
+
+    poly NTT1;
+
+    NTT1 = *src1;
+
+    poly_NTT(&NTT1);
+    poly_point_mul(&NTT1, &NTT1, src2_NTT);
+    poly_iNTT(&NTT1);
+
+    *des = NTT1;
+
+}
+
 // WARNING: This is not constant-time.
 // Please ensure that the inputs are independent from the sensitive data.
 bool poly_test_inv(const poly src){
@@ -58,6 +58,15 @@ void poly_iNTT_generic(poly *src, int32_t *twiddle_table, ZArithData data);
 void poly_point_mul_generic(poly *des, const poly *src1, const poly *src2, ZArithData data);
 
 void poly_mul(poly *des, const poly *src1, const poly *src2);
+
+// poly_mul split into its NTT-domain steps so that operands shared
+// across several products are only transformed once.
+// poly_iNTT expects the output of poly_point_mul.
+void poly_NTT(poly *src);
+void poly_iNTT(poly *src);
+void poly_point_mul(poly *des, const poly *src1, const poly *src2);
+// des = src1 * src2 where src2 is already in the NTT domain.
+void poly_mul_NTT(poly *des, const poly *src1, const poly *src2_NTT);
 bool poly_test_inv(const poly src);
 bool poly_div(poly *des, const poly *src1, const poly *src2);
 
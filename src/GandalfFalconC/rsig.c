@@ -16,32 +16,34 @@
 static
 int Gandalf_signature_check_norm(const poly u[RING_K], const poly v){
 
-    int32_t acc;
+    // GANDALF_BOUND_SQUARE_FLOOR for rings of two, larger for RING_K > 2.
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(RING_K);
+    int64_t acc;
 
     acc = 0;
 
     for(size_t i = 0; i < RING_K; i++){
         for(size_t j = 0; j < N; j++){
-            acc += u[i].coeffs[j] * u[i].coeffs[j];
-            if(acc >= GANDALF_BOUND_SQUARE_FLOOR + 1){
-                acc = GANDALF_BOUND_SQUARE_FLOOR + 1;
+            acc += (int64_t)u[i].coeffs[j] * u[i].coeffs[j];
+            if(acc >= bound + 1){
+                acc = bound + 1;
             }
         }
     }
 
     for(size_t j = 0; j < N; j++){
-        acc += v.coeffs[j] * v.coeffs[j];
-        if(acc >= GANDALF_BOUND_SQUARE_FLOOR + 1){
-            acc = GANDALF_BOUND_SQUARE_FLOOR + 1;
+        acc += (int64_t)v.coeffs[j] * v.coeffs[j];
+        if(acc >= bound + 1){
+            acc = bound + 1;
         }
     }
 
-    return acc <= GANDALF_BOUND_SQUARE_FLOOR;
+    return acc <= bound;
 
 }
 
 static
-void sampler(poly *u, poly *v, const sign_sk *sk, const poly c, const poly h) {
+void sampler(poly *u, poly *v, const sign_sk *sk, const poly c) {
     fpr tmp[7 * N];
     uint8_t seed[56];
     // s1 -> v, s2 -> u
@@ -65,40 +67,107 @@ void sampler(poly *u, poly *v, const sign_sk *sk, const poly c, const poly h) {
 
 }
 
-void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
-        const rsig_pk *pks, const sign_sk *sk, size_t party_id){
+static
+void sampler_expanded(poly *u, poly *v, const sign_expanded_sk *expanded_sk, const poly c) {
+    fpr tmp[4 * N];
+    uint8_t seed[56];
+    // s1 -> v, s2 -> u
+    int16_t s1[N], s2[N];
+    uint16_t c_buff[N];
+
+    randombytes(seed, 56);
+
+    for(size_t i = 0; i < N; i++){
+        c_buff[i] = (uint16_t)c.coeffs[i];
+    }
+    trapdoor_sampler_expanded(LOG_N, s1, s2,
+        expanded_sk->b00, expanded_sk->b01, expanded_sk->b10, expanded_sk->b11,
+        expanded_sk->tree, c_buff, seed, tmp);
+    // c = v + h * u
+    for(size_t i = 0; i < N; i++){
+        u->coeffs[i] = (int32_t)s2[i];
+        v->coeffs[i] = (int32_t)s1[i];
+    }
+
+}
+
+void expand_sign_sk(sign_expanded_sk *expanded_sk, const sign_sk *sk){
+
+    fpr tmp[5 * N];
+
+    assert(sizeof(expanded_sk->tree) == FFLDL_TREE_SIZE(LOG_N) * sizeof(fpr));
+
+    expand_trapdoor_key(LOG_N,
+        expanded_sk->b00, expanded_sk->b01, expanded_sk->b10, expanded_sk->b11,
+        expanded_sk->tree, sk->f, sk->g, sk->F, sk->G, tmp);
+
+}
+
+void sign_pk_to_ntt(sign_pk_ntt *des, const sign_pk *pk){
+
+    des->pk = *pk;
+    unpack_h(&des->h_NTT, &pk->h[0]);
+    poly_NTT(&des->h_NTT);
+
+}
+
+void Gandalf_prepare_pk(rsig_pk_prepared *prepared, const rsig_pk *pks){
+
+    prepared->pks = *pks;
+
+    for(size_t i = 0; i < RING_K; i++){
+        unpack_h(prepared->h_NTT + i, &(pks->hs[i]).h[0]);
+        poly_NTT(prepared->h_NTT + i);
+    }
+
+    hash_ring_init(&prepared->ring_state);
+    shake128_inc_absorb(&prepared->ring_state, (uint8_t*)&prepared->pks, RSIG_PUBLICKEY_BYTES);
+
+}
 
-    poly hash, h_poly;
-    poly v, acc;
+void Gandalf_prepare_pk_ntt(rsig_pk_prepared *prepared, const sign_pk_ntt *members[RING_K]){
+
+    for(size_t i = 0; i < RING_K; i++){
+        prepared->pks.hs[i] = members[i]->pk;
+        prepared->h_NTT[i] = members[i]->h_NTT;
+    }
+
+    hash_ring_init(&prepared->ring_state);
+    shake128_inc_absorb(&prepared->ring_state, (uint8_t*)&prepared->pks, RSIG_PUBLICKEY_BYTES);
+
+}
+
+// Signs with the compact key when expanded_sk is NULL, with expanded_sk otherwise.
+static
+void Gandalf_sign_core(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_sk *sk, const sign_expanded_sk *expanded_sk,
+        size_t party_id){
+
+    poly hash;
+    poly v, prod, acc;
     poly u[RING_K];
     poly c[RING_K];
     int32_t mask;
 
     uint8_t salt[SALT_BYTES];
-    shake128incctx state;
-
-    unpack_h(&h_poly, &(pks->hs[party_id]).h[0]);
 
     do {
 
         randombytes(salt, SALT_BYTES);
+        hash_ring_to_poly(&hash, &pks->ring_state, m, mlen, salt);
 
-        shake128_inc_init(&state);
-        shake128_inc_absorb(&state, (uint8_t*)m, mlen);
-        shake128_inc_absorb(&state, (uint8_t*)pks, RSIG_PUBLICKEY_BYTES);
-        shake128_inc_absorb(&state, (uint8_t*)salt, SALT_BYTES);
-        shake128_inc_finalize(&state);
-        hash_to_poly(&hash, &state);
-
+        // sum_{i != party_id} h[i] * u[i], with a single inverse transform.
         memset(&acc, 0, sizeof(acc));
         for(size_t i = 0; i < RING_K; i++){
             if(i == party_id)
                 continue;
             Gandalf_sample_poly(u + i);
-            unpack_h(&h_poly, &(pks->hs[i]).h[0]);
-            poly_mul(c + i, u + i, &h_poly);
-            poly_add(&acc, &acc, c + i);
+            prod = u[i];
+            poly_NTT(&prod);
+            poly_point_mul(&prod, &prod, pks->h_NTT + i);
+            poly_add(&acc, &acc, &prod);
         }
+        poly_iNTT(&acc);
 
         // c[party_id] = hash - h[!party_id] * u[!party_id]
         poly_sub(c + party_id, &hash, &acc);
@@ -117,11 +186,13 @@ void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
             assert( (0 <= c[party_id].coeffs[i]) && (c[party_id].coeffs[i] < Q) );
         }
 
-        unpack_h(&h_poly, &(pks->hs[party_id]).h[0]);
-
         // c[party_id] = v + h[party_id] * u[party_id]
         // hash = v + h[!party_id] * u[!party_id] + h[party_id] * u[party_id]
-        sampler(u + party_id, &v, sk, c[party_id], h_poly);
+        if(expanded_sk != NULL){
+            sampler_expanded(u + party_id, &v, expanded_sk, c[party_id]);
+        }else{
+            sampler(u + party_id, &v, sk, c[party_id]);
+        }
 
     } while(Gandalf_signature_check_norm(u, v) == 0);
 
@@ -135,28 +206,74 @@ void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
 
 }
 
-int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks){
+void Gandalf_sign_prepared(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_sk *sk, size_t party_id){
+
+    Gandalf_sign_core(s, m, mlen, pks, sk, NULL, party_id);
+
+}
+
+void Gandalf_sign_prepared_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    Gandalf_sign_core(s, m, mlen, pks, NULL, expanded_sk, party_id);
+
+}
+
+void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, const sign_sk *sk, size_t party_id){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+    Gandalf_sign_prepared(s, m, mlen, &prepared, sk, party_id);
+
+}
+
+// Gandalf_sign draws from the samplers all the way down, so ctx is made the
+// thread's context for the call and the previous one put back.
+void Gandalf_sign_ctx(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, const sign_sk *sk, size_t party_id, prng *ctx){
+
+    prng *prev = set_prng_ctx(ctx);
+
+    Gandalf_sign(s, m, mlen, pks, sk, party_id);
+    set_prng_ctx(prev);
+
+}
+
+void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+    Gandalf_sign_prepared_expanded_sk(s, m, mlen, &prepared, expanded_sk, party_id);
+
+}
 
-    poly v, h_poly;
+int Gandalf_verify_prepared(const uint8_t *m, const size_t mlen, const rsig_signature *s,
+        const rsig_pk_prepared *pks){
+
+    poly v;
     poly prod, acc;
     poly u[RING_K];
 
-    shake128incctx state;
-
-    shake128_inc_init(&state);
-    shake128_inc_absorb(&state, (uint8_t*)m, mlen);
-    shake128_inc_absorb(&state, (uint8_t*)pks, RSIG_PUBLICKEY_BYTES);
-    shake128_inc_absorb(&state, (uint8_t*)s->salt, SALT_BYTES);
-    shake128_inc_finalize(&state);
-    hash_to_poly(&v, &state);
+    hash_ring_to_poly(&v, &pks->ring_state, m, mlen, s->salt);
 
+    // sum_i h[i] * u[i] is accumulated in the NTT domain, with a single
+    // inverse transform at the end. Each point product is below Q in
+    // absolute value, so the sum stays well inside the int32_t range the
+    // unreduced iNTT layers can absorb.
     memset(&acc, 0, sizeof(acc));
     for(size_t i = 0; i < RING_K; i++){
-        unpack_h(&h_poly, &(pks->hs[i]).h[0]);
         decompress_u_to_poly(u[i].coeffs, &s->compressed_sign[i]);
-        poly_mul(&prod, &u[i], &h_poly);
+        prod = u[i];
+        poly_NTT(&prod);
+        poly_point_mul(&prod, &prod, pks->h_NTT + i);
         poly_add(&acc, &acc, &prod);
     }
+    poly_iNTT(&acc);
 
     poly_sub(&v, &v, &acc);
     poly_freeze(&v, &v);
@@ -165,3 +282,157 @@ int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s,
 
 }
 
+int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+
+    return Gandalf_verify_prepared(m, mlen, s, &prepared);
+
+}
+
+// ================
+// Rings of k members chosen at run time.
+
+// Ring state of H(version || members[0].pk || ... || members[k - 1].pk || m || salt),
+// with the public keys streamed into SHAKE128 one member at a time.
+static
+void Gandalf_ring_state_k(shake128incctx *ring_state, const sign_pk_ntt *const *members, size_t k){
+
+    hash_ring_init(ring_state);
+    for(size_t i = 0; i < k; i++){
+        shake128_inc_absorb(ring_state, (uint8_t*)&members[i]->pk, SIGN_PUBLICKEY_BYTES);
+    }
+
+}
+
+// Adds the squared norm of src to acc, saturating at bound + 1.
+static
+int64_t Gandalf_norm_add_k(int64_t acc, const poly *src, int64_t bound){
+
+    for(size_t j = 0; j < N; j++){
+        acc += (int64_t)src->coeffs[j] * src->coeffs[j];
+    }
+
+    return (acc > bound) ? (bound + 1) : acc;
+
+}
+
+// Non-signer members are compressed into s as soon as they are sampled, so
+// a single u is live at a time whatever the ring size.
+static
+void Gandalf_sign_k_core(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_sk *sk,
+        const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    poly hash;
+    poly u, v, prod, acc;
+    int64_t norm;
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(k);
+    int32_t mask;
+    uint8_t *salt = s + k * COMPRESSED_SIGN_SIGNATURE_BYTES;
+    shake128incctx ring_state;
+
+    assert(party_id < k);
+
+    // The ring is absorbed once; each attempt only absorbs m and the salt.
+    Gandalf_ring_state_k(&ring_state, members, k);
+
+    do {
+
+        randombytes(salt, SALT_BYTES);
+        hash_ring_to_poly(&hash, &ring_state, m, mlen, salt);
+
+        norm = 0;
+        memset(&acc, 0, sizeof(acc));
+        for(size_t i = 0; i < k; i++){
+            if(i == party_id)
+                continue;
+            Gandalf_sample_poly(&u);
+            norm = Gandalf_norm_add_k(norm, &u, bound);
+            compress_u_from_poly(s + i * COMPRESSED_SIGN_SIGNATURE_BYTES, u.coeffs);
+            prod = u;
+            poly_NTT(&prod);
+            poly_point_mul(&prod, &prod, &members[i]->h_NTT);
+            poly_add(&acc, &acc, &prod);
+        }
+        poly_iNTT(&acc);
+
+        // hash <- c[party_id] = hash - sum_{i != party_id} h[i] * u[i]
+        poly_sub(&hash, &hash, &acc);
+        poly_freeze(&hash, &hash);
+
+        for(size_t i = 0; i < N; i++){
+
+            mask = hash.coeffs[i];
+            mask = -((mask >> 31) & 1);
+            hash.coeffs[i] += (Q & mask);
+
+            mask = ((Q - 1) - hash.coeffs[i]);
+            mask = -((mask >> 31) & 1);
+            hash.coeffs[i] -= (Q & mask);
+
+            assert( (0 <= hash.coeffs[i]) && (hash.coeffs[i] < Q) );
+        }
+
+        if(expanded_sk != NULL){
+            sampler_expanded(&u, &v, expanded_sk, hash);
+        }else{
+            sampler(&u, &v, sk, hash);
+        }
+
+        norm = Gandalf_norm_add_k(norm, &u, bound);
+        norm = Gandalf_norm_add_k(norm, &v, bound);
+
+    } while(norm > bound);
+
+    compress_u_from_poly(s + party_id * COMPRESSED_SIGN_SIGNATURE_BYTES, u.coeffs);
+
+}
+
+void Gandalf_sign_k(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_sk *sk, size_t party_id){
+
+    Gandalf_sign_k_core(s, m, mlen, members, k, sk, NULL, party_id);
+
+}
+
+void Gandalf_sign_k_expanded_sk(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    Gandalf_sign_k_core(s, m, mlen, members, k, NULL, expanded_sk, party_id);
+
+}
+
+int Gandalf_verify_k(const uint8_t *m, const size_t mlen, const uint8_t *s,
+        const sign_pk_ntt *const *members, size_t k){
+
+    poly u, v, prod, acc;
+    int64_t norm;
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(k);
+    shake128incctx ring_state;
+
+    Gandalf_ring_state_k(&ring_state, members, k);
+    hash_ring_to_poly(&v, &ring_state, m, mlen, s + k * COMPRESSED_SIGN_SIGNATURE_BYTES);
+
+    norm = 0;
+    memset(&acc, 0, sizeof(acc));
+    for(size_t i = 0; i < k; i++){
+        decompress_u_to_poly(u.coeffs, s + i * COMPRESSED_SIGN_SIGNATURE_BYTES);
+        norm = Gandalf_norm_add_k(norm, &u, bound);
+        prod = u;
+        poly_NTT(&prod);
+        poly_point_mul(&prod, &prod, &members[i]->h_NTT);
+        poly_add(&acc, &acc, &prod);
+    }
+    poly_iNTT(&acc);
+
+    poly_sub(&v, &v, &acc);
+    poly_freeze(&v, &v);
+    norm = Gandalf_norm_add_k(norm, &v, bound);
+
+    return norm <= bound;
+
+}
+
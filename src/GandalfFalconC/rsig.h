@@ -2,14 +2,37 @@
 #define RSIG_H
 
 #include "rsig_params.h"
+#include "randombytes.h"
 #include "rsig_keygen_helper.h"
 #include <stddef.h>
 
 int32_t Gandalf_Gaussian_sampler();
 
+void expand_sign_sk(sign_expanded_sk *expanded_sk, const sign_sk *sk);
+
 void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
         const sign_sk *sk, size_t party_id);
+void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
+        const sign_expanded_sk *expanded_sk, size_t party_id);
 int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks);
+void Gandalf_sign_ctx(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
+        const sign_sk *sk, size_t party_id, prng *ctx);
+
+void sign_pk_to_ntt(sign_pk_ntt *des, const sign_pk *pk);
+void Gandalf_prepare_pk(rsig_pk_prepared *prepared, const rsig_pk *pks);
+void Gandalf_prepare_pk_ntt(rsig_pk_prepared *prepared, const sign_pk_ntt *members[RING_K]);
+void Gandalf_sign_prepared(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk_prepared *pks,
+        const sign_sk *sk, size_t party_id);
+void Gandalf_sign_prepared_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_expanded_sk *expanded_sk, size_t party_id);
+int Gandalf_verify_prepared(const uint8_t *m, const size_t mlen, const rsig_signature *s,
+        const rsig_pk_prepared *pks);
+void Gandalf_sign_k(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_sk *sk, size_t party_id);
+void Gandalf_sign_k_expanded_sk(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_expanded_sk *expanded_sk, size_t party_id);
+int Gandalf_verify_k(const uint8_t *m, const size_t mlen, const uint8_t *s,
+        const sign_pk_ntt *const *members, size_t k);
 
 #endif
 
@@ -1,18 +1,35 @@
 #ifndef RSIG_API_H
 #define RSIG_API_H
 
+#include "fips202.h"
+
 #include <stddef.h>
 #include <stdint.h>
 
 #define SIGN_PUBLICKEY_BYTES 896
 #define SIGN_SECRETKEY_BYTES 2048
 #define SIGN_SIGNATURE_BYTES 650
-#define RSIG_PUBLICKEY_BYTES 1792
-#define RSIG_SIGNATURE_BYTES 1276
 
 #define COMPRESSED_SIGN_SIGNATURE_BYTES 626
 #define SALT_BYTES 24
+
+// Version of the signature format, absorbed first into the hash to the
+// point. Version 2 hashes H(version || pks || m || salt) so that the ring
+// is absorbed once per ring; version 1 hashed H(m || pks || salt).
+#define RSIG_SIGNATURE_VERSION 2
+
+// Number of ring members. The AKEMs use rings of two; larger rings can be
+// built with -DRING_K=k for the ring signature alone.
+#ifndef RING_K
 #define RING_K 2
+#endif
+
+#define RSIG_PUBLICKEY_BYTES (RING_K * SIGN_PUBLICKEY_BYTES)
+#define RSIG_SIGNATURE_BYTES (RING_K * COMPRESSED_SIGN_SIGNATURE_BYTES + SALT_BYTES)
+
+// Signature size of a ring of k members for Gandalf_sign_k/Gandalf_verify_k:
+// k compressed u followed by the salt, as in rsig_signature.
+#define RSIG_SIGNATURE_BYTES_K(k) ((k) * COMPRESSED_SIGN_SIGNATURE_BYTES + SALT_BYTES)
 
 typedef struct{
   int32_t coeffs[512];
@@ -26,6 +43,18 @@ typedef struct{
     int8_t G[512];
 } sign_sk;
 
+// N = 512. The basis [[g, -f], [G, -F]] in FFT representation and the
+// LDL tree of its Gram matrix ((LOG_N + 1) * N entries), so that signing
+// skips the per-call basis and tree computations. Entries are the raw
+// bit patterns of doubles.
+typedef struct{
+    uint64_t b00[512];
+    uint64_t b01[512];
+    uint64_t b10[512];
+    uint64_t b11[512];
+    uint64_t tree[10 * 512];
+} sign_expanded_sk;
+
 // N = 512
 typedef struct{
     uint8_t h[896];
@@ -45,10 +74,52 @@ typedef struct {
     uint8_t salt[SALT_BYTES];
 } rsig_signature;
 
+// One public key decoded and in the NTT domain, for long-lived identities
+// that appear in many rings.
+typedef struct {
+    sign_pk pk;
+    poly h_NTT;
+} sign_pk_ntt;
+
+// Ring public key with every member decoded and in the NTT domain, and
+// the SHAKE128 state after absorbing the version and the ring public key.
+// Prepare once per ring and reuse it across signatures and verifications.
+typedef struct {
+    rsig_pk pks;
+    poly h_NTT[RING_K];
+    shake128incctx ring_state;
+} rsig_pk_prepared;
+
 void sign_keygen(sign_sk *sk, sign_pk *pk);
+void expand_sign_sk(sign_expanded_sk *expanded_sk, const sign_sk *sk);
+
 void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
     const sign_sk *sk, size_t party_id);
+void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk *pks,
+    const sign_expanded_sk *expanded_sk, size_t party_id);
 int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks);
 
+void sign_pk_to_ntt(sign_pk_ntt *des, const sign_pk *pk);
+void Gandalf_prepare_pk(rsig_pk_prepared *prepared, const rsig_pk *pks);
+// Assembles a prepared ring from members transformed by sign_pk_to_ntt.
+void Gandalf_prepare_pk_ntt(rsig_pk_prepared *prepared, const sign_pk_ntt *members[RING_K]);
+void Gandalf_sign_prepared(rsig_signature *s, const uint8_t *m, const size_t mlen, const rsig_pk_prepared *pks,
+    const sign_sk *sk, size_t party_id);
+void Gandalf_sign_prepared_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+    const rsig_pk_prepared *pks, const sign_expanded_sk *expanded_sk, size_t party_id);
+int Gandalf_verify_prepared(const uint8_t *m, const size_t mlen, const rsig_signature *s,
+    const rsig_pk_prepared *pks);
+
+// Rings of k >= 1 members chosen at run time, given as an array of k
+// members from sign_pk_ntt. s holds RSIG_SIGNATURE_BYTES_K(k) bytes. The
+// members are absorbed into the hash in order, so for k = RING_K these
+// accept and produce the same signatures as Gandalf_sign/Gandalf_verify.
+void Gandalf_sign_k(uint8_t *s, const uint8_t *m, const size_t mlen,
+    const sign_pk_ntt *const *members, size_t k, const sign_sk *sk, size_t party_id);
+void Gandalf_sign_k_expanded_sk(uint8_t *s, const uint8_t *m, const size_t mlen,
+    const sign_pk_ntt *const *members, size_t k, const sign_expanded_sk *expanded_sk, size_t party_id);
+int Gandalf_verify_k(const uint8_t *m, const size_t mlen, const uint8_t *s,
+    const sign_pk_ntt *const *members, size_t k);
+
 #endif
 
@@ -2,8 +2,10 @@
 #define RSIG_KEYGEN_HELPER_H
 
 #include "rsig_params.h"
+#include "randombytes.h"
 
 void sign_keygen(sign_sk *sk, sign_pk *pk);
+void sign_keygen_ctx(sign_sk *sk, sign_pk *pk, prng *ctx);
 
 #endif
 
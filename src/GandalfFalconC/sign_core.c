@@ -169,6 +169,89 @@ trapdoor_sampler(unsigned logn,
 
 }
 
+/* see sign_inner.h */
+void
+expand_trapdoor_key(unsigned logn,
+	fpr *b00, fpr *b01, fpr *b10, fpr *b11, fpr *tree,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	void *tmp)
+{
+	size_t n = (size_t)1 << logn;
+
+	/* Layout of tmp[]:
+	      g00 (n)
+	      g01 (n)
+	      g11 (n)
+	      free space for ffLDL_tree() (2n)  */
+	fpr *g00 = (fpr *)tmp;
+	fpr *g01 = g00 + n;
+	fpr *g11 = g01 + n;
+
+	basis_to_FFT(logn, b00, b01, b10, b11, f, g, F, G);
+	memcpy(g00, b00, n * sizeof(fpr));
+	memcpy(g01, b01, n * sizeof(fpr));
+	memcpy(g11, b10, n * sizeof(fpr));
+	fpoly_gram_fft(logn, g00, g01, g11, b11);
+	ffLDL_tree(logn, tree, g00, g01, g11, g11 + n);
+}
+
+/* see sign_inner.h */
+void
+trapdoor_sampler_expanded(unsigned logn,
+		int16_t *s1, int16_t *s2,
+		const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+		const fpr *tree, const uint16_t *c, const uint8_t *subseed,
+		void *tmp) {
+
+		size_t n = (size_t)1 << logn;
+
+		sampler_state ss;
+		sampler_init(&ss, logn, subseed, 56);
+
+		/* Layout of tmp[]:
+		      t0 (n)
+		      t1 (n)
+		      free space (2n)
+		   fpoly_apply_basis() multiplies into its b01 argument, so it
+		   gets a copy; b11 is only read. */
+		fpr *t0 = (fpr *)tmp;
+		fpr *t1 = t0 + n;
+		fpr *w0 = t1 + n;
+		fpr *w1 = w0 + n;
+		memcpy(w0, b01, n * sizeof(fpr));
+		fpoly_apply_basis(logn, t0, t1, w0, (fpr *)b11, c);
+
+		ffsamp_tree(&ss, tree, t0);
+
+		/* Lattice point [v0,v1] = [t0,t1] * [[g, -f], [G, -F]], as in
+		   trapdoor_sampler(), with FFT(g), FFT(f), FFT(G) and FFT(F)
+		   taken from the expanded basis instead of being recomputed:
+		   b00 = FFT(g), b01 = -FFT(f), b10 = FFT(G), b11 = -FFT(F). */
+		memcpy(w1, b01, n * sizeof(fpr));
+		fpoly_neg(logn, w1);
+		fpoly_mul_fft(logn, w1, t0);
+		fpoly_mul_fft(logn, t0, b00);
+		memcpy(w0, b10, n * sizeof(fpr));
+		fpoly_mul_fft(logn, w0, t1);
+		fpoly_add(logn, t0, w0);
+		memcpy(w0, b11, n * sizeof(fpr));
+		fpoly_neg(logn, w0);
+		fpoly_mul_fft(logn, t1, w0);
+		fpoly_add(logn, t1, w1);
+		fpoly_neg(logn, t1);
+		fpoly_iFFT(logn, t0);
+		fpoly_iFFT(logn, t1);
+
+		for(size_t i = 0; i < n; i++){
+			s1[i] = (int16_t)(c[i] - (uint16_t)fpr_rint(t0[i]));
+		}
+
+		for(size_t i = 0; i < n; i++){
+			s2[i] = (int16_t)(-(uint16_t)fpr_rint(t1[i]));
+		}
+
+}
+
 static
 uint32_t compute_sqn(const size_t n, int16_t *s1, int16_t *s2){
 		/* We compute the saturated squared norm in sqn with
@@ -330,3 +330,17 @@ int sign_keygen_expanded_sk(sign_expanded_sk *expanded_sk, sign_pk *pk){
 
 }
 
+// keygen_fg samples (f, g) coefficient by coefficient, so ctx is made the
+// thread's context for the call and the previous one put back.
+int sign_keygen_ctx(sign_sk *sk, sign_pk *pk, prng *ctx){
+
+    prng *prev = set_prng_ctx(ctx);
+    int trials;
+
+    trials = sign_keygen(sk, pk);
+    set_prng_ctx(prev);
+
+    return trials;
+
+}
+
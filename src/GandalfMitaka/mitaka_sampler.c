@@ -9,6 +9,35 @@
 #include <stddef.h>
 #include <string.h>
 
+/* Define MITAKA_SAMPLER_AVX2 to 0 in order to disable the AVX2 engine.
+   The engine is gated at runtime on CPU support of AVX2 and FMA. */
+#ifndef MITAKA_SAMPLER_AVX2
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define MITAKA_SAMPLER_AVX2   1
+#else
+#define MITAKA_SAMPLER_AVX2   0
+#endif
+#endif
+
+/* Define MITAKA_SAMPLER_NEON to 1 on aarch64 to enable the NEON engine. It
+   is off by default until it has been built and tested on an aarch64
+   target. */
+#ifndef MITAKA_SAMPLER_NEON
+#define MITAKA_SAMPLER_NEON   0
+#endif
+#if MITAKA_SAMPLER_NEON && !(defined __aarch64__ && defined __ARM_NEON)
+#error "MITAKA_SAMPLER_NEON needs an aarch64 target with NEON"
+#endif
+
+#if MITAKA_SAMPLER_AVX2
+#include <immintrin.h>
+#define TARGET_SAMPLER_AVX2   __attribute__((target("avx2,fma")))
+#endif
+
+#if MITAKA_SAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
 uint64_t CDT[TABLE_SIZE] = {8562458705743934607LLU,
                            14988938141546119862LLU,
                            17705984313312429518LLU,
@@ -29,16 +58,13 @@ uint64_t CDT[TABLE_SIZE] = {8562458705743934607LLU,
 #define CFLIP(x,c)      CMUX(x,-(x),c)
 #define CZERO64(x)      ((~(x)&((x)-1))>>63)
 
-/* Store a double-precision centered normal vector in vec.
- * Computation using Box-Muller. N is assumed to be even.
- * Standard deviation is N/2, so that the output vector has
- * the same distribution as the FFT of a standard normal vector.
- */
-void normaldist(fpoly *vec)
+// Draws the inputs of Box-Muller for N/2 pairs: the angles t in [0, 1)
+// (in turns), the uniforms w in [0.5, 1) and the geometric exponents g, so
+// that the radius is sqrt(N * (ln(2) * g - log(w))).
+static
+void normaldist_inputs(double *t, double *w, double *g)
 {
     uint64_t u[N/2], v[N/2], e[N];
-    double uf[N/2], vf[N/2];
-    int geom[N/2];
 
     randombytes((uint8_t*)u, sizeof u);
     randombytes((uint8_t*)v, sizeof v);
@@ -54,21 +80,262 @@ void normaldist(fpoly *vec)
     */
 
     for(int i=0; i < N/2; i++) {
-        uf[i] = 2*M_PI*(double)(u[i] & 0x1FFFFFFFFFFFFFul) * pow(2,-53);
-        vf[i] = 0.5 + (double)(v[i] & 0x1FFFFFFFFFFFFFul) * pow(2,-54);
-
-        geom[i] = CMUX(63 + ffsll(e[2*i+1]), ffsll(e[2*i]) - 1,
+        t[i] = (double)(u[i] & 0x1FFFFFFFFFFFFFul) * 0x1p-53;
+        w[i] = 0.5 + (double)(v[i] & 0x1FFFFFFFFFFFFFul) * 0x1p-54;
+        g[i] = CMUX(63 + ffsll(e[2*i+1]), ffsll(e[2*i]) - 1,
             CZERO64(e[2*i]));
-
-        vf[i] = sqrt(N*(M_LN2*geom[i]-log(vf[i])));
     }
+}
+
+/* Store a double-precision centered normal vector in vec.
+ * Computation using Box-Muller. N is assumed to be even.
+ * Standard deviation is N/2, so that the output vector has
+ * the same distribution as the FFT of a standard normal vector.
+ */
+void normaldist_ref(fpoly *vec)
+{
+    double t[N/2], w[N/2], g[N/2];
+    double uf, vf;
+
+    normaldist_inputs(t, w, g);
 
     for(int i=0; i < N/2; i++) {
-        vec->coeffs[2*i].v   = vf[i] * cos(uf[i]);
-        vec->coeffs[2*i+1].v = vf[i] * sin(uf[i]);
+        uf = 2*M_PI*t[i];
+        vf = sqrt(N*(M_LN2*g[i]-log(w[i])));
+        vec->coeffs[2*i].v   = vf * cos(uf);
+        vec->coeffs[2*i+1].v = vf * sin(uf);
     }
 }
 
+#if MITAKA_SAMPLER_AVX2 || MITAKA_SAMPLER_NEON
+
+// Polynomial approximations of the vector kernels. Inputs are reduced to
+//   log(w) = 2 s (1 + s^2/3 + ... + s^20/21),  s = (w - 1)/(w + 1),
+// after scaling w into [sqrt(1/2), 1), so |s| <= 0.172, and to Taylor
+// series of sin and cos on [0, pi/2) after taking out the quadrant of t.
+// The truncation errors are below 2^-60.
+//
+// Error budget. The security argument only needs the density of each
+// perturbation coefficient to be within a relative error delta of the
+// ideal Gaussian. By [Pre17, Lemma 3] (T. Prest, Sharper bounds in
+// lattice-based cryptography using the Renyi divergence, ASIACRYPT 2017),
+// Q_s signatures of m coefficients each then have a Renyi divergence of
+// order a of at most (1 + a (a - 1) delta^2 / 2)^(m Q_s) to the ideal ones,
+// to first order in delta, and a = 2 lambda with
+// a (a - 1) delta^2 m Q_s / 2 <= 1 costs about one bit of security
+// [Pre17, Sec. 3]. With lambda = 128, Q_s = 2^64 and m = 2N = 2^10
+// (FFTy1 and FFTy2), this gives delta <= 2^-44.5.
+//
+// Each pair has the ideal density exp(-r^2 / N) up to a constant (standard
+// deviation N/2 per coordinate), which is constant along circles, so an
+// output with squared radius r'^2 instead of r^2 has a relative density
+// error of about |r'^2 - r^2| / N. The kernels are held to
+// NORMALDIST_DENSITY_ERROR_BOUND = 2^-46 over normaldist_ref (checked by
+// the rsig test). The rest of the budget covers the rounding of
+// normaldist_ref itself, about 2^-52 r^2 / N, i.e. at most 2^-45.5 for the
+// largest geometric exponents g.
+static const double normaldist_log_coef[11] = {
+    1.0, 0.33333333333333331, 0.20000000000000001, 0.14285714285714285,
+    0.1111111111111111, 0.090909090909090912, 0.076923076923076927,
+    0.066666666666666666, 0.058823529411764705, 0.052631578947368418,
+    0.047619047619047616
+};
+
+static const double normaldist_sin_coef[12] = {
+    1.0, -0.16666666666666666, 0.0083333333333333332, -0.00019841269841269841,
+    2.7557319223985893e-06, -2.505210838544172e-08, 1.6059043836821613e-10,
+    -7.6471637318198164e-13, 2.8114572543455206e-15, -8.2206352466243295e-18,
+    1.9572941063391263e-20, -3.8681701706306841e-23
+};
+
+static const double normaldist_cos_coef[13] = {
+    1.0, -0.5, 0.041666666666666664, -0.0013888888888888889,
+    2.4801587301587302e-05, -2.7557319223985888e-07, 2.08767569878681e-09,
+    -1.1470745597729725e-11, 4.7794773323873853e-14, -1.5619206968586225e-16,
+    4.1103176233121648e-19, -8.8967913924505741e-22, 1.6117375710961184e-24
+};
+
+#define NORMALDIST_SQRT2        1.4142135623730951
+#define NORMALDIST_SQRT1_2      0.70710678118654757
+#define NORMALDIST_HALF_LN2     0.34657359027997264
+#define NORMALDIST_PI_2         1.5707963267948966
+
+#endif
+
+#if MITAKA_SAMPLER_AVX2
+
+// Four pairs per iteration; the (cos, sin) lanes are interleaved back into
+// the layout of normaldist_ref before the stores.
+TARGET_SAMPLER_AVX2
+static
+void normaldist_avx2(fpoly *vec)
+{
+    double t[N/2], w[N/2], g[N/2];
+    double *out = (double*)vec->coeffs;
+
+    const __m256d one       = _mm256_set1_pd(1.0);
+    const __m256d two       = _mm256_set1_pd(2.0);
+    const __m256d four      = _mm256_set1_pd(4.0);
+    const __m256d neg_zero  = _mm256_set1_pd(-0.0);
+    const __m256d ln2       = _mm256_set1_pd(M_LN2);
+    const __m256d n         = _mm256_set1_pd((double)N);
+    const __m256d sqrt2     = _mm256_set1_pd(NORMALDIST_SQRT2);
+    const __m256d sqrt1_2   = _mm256_set1_pd(NORMALDIST_SQRT1_2);
+    const __m256d half_ln2  = _mm256_set1_pd(NORMALDIST_HALF_LN2);
+    const __m256d pi_2      = _mm256_set1_pd(NORMALDIST_PI_2);
+
+    __m256d vt, vw, vg, m, s, z, p, r, q, th, sp, cp, m1, m2, m3, odd, sn, cs, lo, hi;
+
+    normaldist_inputs(t, w, g);
+
+    for(size_t i = 0; i < N/2; i += 4){
+
+        vt = _mm256_loadu_pd(t + i);
+        vw = _mm256_loadu_pd(w + i);
+        vg = _mm256_loadu_pd(g + i);
+
+        // radius
+        m = _mm256_cmp_pd(vw, sqrt1_2, _CMP_LT_OQ);
+        vw = _mm256_blendv_pd(vw, _mm256_mul_pd(vw, sqrt2), m);
+        s = _mm256_div_pd(_mm256_sub_pd(vw, one), _mm256_add_pd(vw, one));
+        z = _mm256_mul_pd(s, s);
+        p = _mm256_set1_pd(normaldist_log_coef[10]);
+        for(int k = 9; k >= 0; k--){
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(normaldist_log_coef[k]));
+        }
+        p = _mm256_mul_pd(_mm256_mul_pd(two, s), p);
+        p = _mm256_sub_pd(p, _mm256_and_pd(m, half_ln2));
+        r = _mm256_sqrt_pd(_mm256_mul_pd(n, _mm256_fmsub_pd(ln2, vg, p)));
+
+        // angle: t = (q + th / (pi / 2)) / 4 with q the quadrant
+        vt = _mm256_mul_pd(vt, four);
+        q = _mm256_floor_pd(vt);
+        th = _mm256_mul_pd(_mm256_sub_pd(vt, q), pi_2);
+        z = _mm256_mul_pd(th, th);
+        sp = _mm256_set1_pd(normaldist_sin_coef[11]);
+        for(int k = 10; k >= 0; k--){
+            sp = _mm256_fmadd_pd(sp, z, _mm256_set1_pd(normaldist_sin_coef[k]));
+        }
+        sp = _mm256_mul_pd(sp, th);
+        cp = _mm256_set1_pd(normaldist_cos_coef[12]);
+        for(int k = 11; k >= 0; k--){
+            cp = _mm256_fmadd_pd(cp, z, _mm256_set1_pd(normaldist_cos_coef[k]));
+        }
+
+        m1 = _mm256_cmp_pd(q, one, _CMP_EQ_OQ);
+        m2 = _mm256_cmp_pd(q, two, _CMP_EQ_OQ);
+        m3 = _mm256_cmp_pd(q, _mm256_set1_pd(3.0), _CMP_EQ_OQ);
+        odd = _mm256_or_pd(m1, m3);
+        sn = _mm256_blendv_pd(sp, cp, odd);
+        cs = _mm256_blendv_pd(cp, sp, odd);
+        sn = _mm256_xor_pd(sn, _mm256_and_pd(_mm256_or_pd(m2, m3), neg_zero));
+        cs = _mm256_xor_pd(cs, _mm256_and_pd(_mm256_or_pd(m1, m2), neg_zero));
+        sn = _mm256_mul_pd(r, sn);
+        cs = _mm256_mul_pd(r, cs);
+
+        lo = _mm256_unpacklo_pd(cs, sn);
+        hi = _mm256_unpackhi_pd(cs, sn);
+        _mm256_storeu_pd(out + 2 * i + 0, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(out + 2 * i + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+
+    }
+}
+
+#endif
+
+#if MITAKA_SAMPLER_NEON
+
+// Two pairs per iteration, as normaldist_avx2.
+static
+void normaldist_neon(fpoly *vec)
+{
+    double t[N/2], w[N/2], g[N/2];
+    double *out = (double*)vec->coeffs;
+
+    const float64x2_t one       = vdupq_n_f64(1.0);
+    const float64x2_t two       = vdupq_n_f64(2.0);
+    const float64x2_t three     = vdupq_n_f64(3.0);
+    const float64x2_t four      = vdupq_n_f64(4.0);
+    const uint64x2_t sign       = vdupq_n_u64(0x8000000000000000ul);
+    const float64x2_t ln2       = vdupq_n_f64(M_LN2);
+    const float64x2_t n         = vdupq_n_f64((double)N);
+    const float64x2_t sqrt2     = vdupq_n_f64(NORMALDIST_SQRT2);
+    const float64x2_t sqrt1_2   = vdupq_n_f64(NORMALDIST_SQRT1_2);
+    const float64x2_t half_ln2  = vdupq_n_f64(NORMALDIST_HALF_LN2);
+    const float64x2_t pi_2      = vdupq_n_f64(NORMALDIST_PI_2);
+
+    float64x2_t vt, vw, vg, s, z, p, r, q, th, sp, cp, sn, cs;
+    uint64x2_t m, m1, m2, m3, odd;
+
+    normaldist_inputs(t, w, g);
+
+    for(size_t i = 0; i < N/2; i += 2){
+
+        vt = vld1q_f64(t + i);
+        vw = vld1q_f64(w + i);
+        vg = vld1q_f64(g + i);
+
+        // radius
+        m = vcltq_f64(vw, sqrt1_2);
+        vw = vbslq_f64(m, vmulq_f64(vw, sqrt2), vw);
+        s = vdivq_f64(vsubq_f64(vw, one), vaddq_f64(vw, one));
+        z = vmulq_f64(s, s);
+        p = vdupq_n_f64(normaldist_log_coef[10]);
+        for(int k = 9; k >= 0; k--){
+            p = vfmaq_f64(vdupq_n_f64(normaldist_log_coef[k]), p, z);
+        }
+        p = vmulq_f64(vmulq_f64(two, s), p);
+        p = vsubq_f64(p, vreinterpretq_f64_u64(vandq_u64(m, vreinterpretq_u64_f64(half_ln2))));
+        r = vsqrtq_f64(vmulq_f64(n, vfmsq_f64(vmulq_f64(ln2, vg), one, p)));
+
+        // angle: t = (q + th / (pi / 2)) / 4 with q the quadrant
+        vt = vmulq_f64(vt, four);
+        q = vrndmq_f64(vt);
+        th = vmulq_f64(vsubq_f64(vt, q), pi_2);
+        z = vmulq_f64(th, th);
+        sp = vdupq_n_f64(normaldist_sin_coef[11]);
+        for(int k = 10; k >= 0; k--){
+            sp = vfmaq_f64(vdupq_n_f64(normaldist_sin_coef[k]), sp, z);
+        }
+        sp = vmulq_f64(sp, th);
+        cp = vdupq_n_f64(normaldist_cos_coef[12]);
+        for(int k = 11; k >= 0; k--){
+            cp = vfmaq_f64(vdupq_n_f64(normaldist_cos_coef[k]), cp, z);
+        }
+
+        m1 = vceqq_f64(q, one);
+        m2 = vceqq_f64(q, two);
+        m3 = vceqq_f64(q, three);
+        odd = vorrq_u64(m1, m3);
+        sn = vbslq_f64(odd, cp, sp);
+        cs = vbslq_f64(odd, sp, cp);
+        sn = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(sn), vandq_u64(vorrq_u64(m2, m3), sign)));
+        cs = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(cs), vandq_u64(vorrq_u64(m1, m2), sign)));
+        sn = vmulq_f64(r, sn);
+        cs = vmulq_f64(r, cs);
+
+        vst1q_f64(out + 2 * i + 0, vzip1q_f64(cs, sn));
+        vst1q_f64(out + 2 * i + 2, vzip2q_f64(cs, sn));
+
+    }
+}
+
+#endif
+
+void normaldist(fpoly *vec)
+{
+#if MITAKA_SAMPLER_AVX2
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        normaldist_avx2(vec);
+        return;
+    }
+#elif MITAKA_SAMPLER_NEON
+    normaldist_neon(vec);
+    return;
+#endif
+    normaldist_ref(vec);
+}
+
 int32_t base_sampler(){
     uint64_t r = get64();
     int32_t res = 0;
@@ -102,19 +369,236 @@ int32_t samplerZ(double u){
     }
 }
 
+// The batch sampler below runs the rejection loop of samplerZ on
+// MITAKA_SAMPLERZ_BATCH centers at once. Every round draws a candidate and
+// an acceptance test for all lanes and updates them through masks, so the
+// work inside a round is independent of the samples; only the number of
+// rounds is data dependent, as the number of trials of samplerZ is.
+//
+// In a round, z0 is a half-Gaussian sample and z = z0 + 1 + floor(u) or
+// -z0 + floor(u), so that |z - u| >= z0 and the exponent
+//     x = (z0^2 - (z - u)^2) / (2 R^2)
+// lies in [-(2 * (TABLE_SIZE - 1) + 1) / (2 R^2), 0].
+// exp(x) = 2^k exp(f) with k = round(x / ln(2)) and |f| <= ln(2) / 2, and
+// exp(f) is a Taylor polynomial of degree 12, within 2^-52 relative to
+// libm; the acceptance test compares against a 53-bit uniform, so the
+// difference with samplerZ is far below statistical resolution.
+static const double samplerZ_exp_coef[13] = {
+    1.0, 1.0, 0.5, 0.16666666666666666, 0.041666666666666664,
+    0.0083333333333333332, 0.0013888888888888889, 0.00019841269841269841,
+    2.4801587301587302e-05, 2.7557319223985893e-06, 2.7557319223985888e-07,
+    2.505210838544172e-08, 2.08767569878681e-09
+};
+
+#define SAMPLERZ_LOG2E          1.4426950408889634
+#define SAMPLERZ_LN2_HI         0.69314718055966296
+#define SAMPLERZ_LN2_LO         2.3190468138462996e-11
+
+// 2^52 + 1023: adding k yields the biased exponent k + 1023 in the low bits.
+#define SAMPLERZ_EXP_MAGIC      4503599627371519.0
+
+static
+void samplerZ_exp_batch_portable(double *p, const double *x){
+
+    double k, f, e;
+    union { double d; uint64_t u; } t;
+
+    for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j++){
+        k = nearbyint(x[j] * SAMPLERZ_LOG2E);
+        f = (x[j] - k * SAMPLERZ_LN2_HI) - k * SAMPLERZ_LN2_LO;
+        e = samplerZ_exp_coef[12];
+        for(int i = 11; i >= 0; i--){
+            e = e * f + samplerZ_exp_coef[i];
+        }
+        t.d = k + SAMPLERZ_EXP_MAGIC;
+        t.u <<= 52;
+        p[j] = e * t.d;
+    }
+
+}
+
+#if MITAKA_SAMPLER_AVX2
+
+TARGET_SAMPLER_AVX2
+static
+void samplerZ_exp_batch_avx2(double *p, const double *x){
+
+    const __m256d log2e  = _mm256_set1_pd(SAMPLERZ_LOG2E);
+    const __m256d ln2_hi = _mm256_set1_pd(SAMPLERZ_LN2_HI);
+    const __m256d ln2_lo = _mm256_set1_pd(SAMPLERZ_LN2_LO);
+    const __m256d magic  = _mm256_set1_pd(SAMPLERZ_EXP_MAGIC);
+
+    __m256d vx, k, f, e, t;
+
+    for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j += 4){
+        vx = _mm256_loadu_pd(x + j);
+        k = _mm256_round_pd(_mm256_mul_pd(vx, log2e), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        f = _mm256_fnmadd_pd(k, ln2_lo, _mm256_fnmadd_pd(k, ln2_hi, vx));
+        e = _mm256_set1_pd(samplerZ_exp_coef[12]);
+        for(int i = 11; i >= 0; i--){
+            e = _mm256_fmadd_pd(e, f, _mm256_set1_pd(samplerZ_exp_coef[i]));
+        }
+        t = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(k, magic)), 52));
+        _mm256_storeu_pd(p + j, _mm256_mul_pd(e, t));
+    }
+
+}
+
+#endif
+
+#if MITAKA_SAMPLER_NEON
+
+static
+void samplerZ_exp_batch_neon(double *p, const double *x){
+
+    const float64x2_t log2e  = vdupq_n_f64(SAMPLERZ_LOG2E);
+    const float64x2_t ln2_hi = vdupq_n_f64(SAMPLERZ_LN2_HI);
+    const float64x2_t ln2_lo = vdupq_n_f64(SAMPLERZ_LN2_LO);
+
+    float64x2_t vx, k, f, e, t;
+    int64x2_t ki;
+
+    for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j += 2){
+        vx = vld1q_f64(x + j);
+        ki = vcvtnq_s64_f64(vmulq_f64(vx, log2e));
+        k = vcvtq_f64_s64(ki);
+        f = vfmsq_f64(vfmsq_f64(vx, k, ln2_hi), k, ln2_lo);
+        e = vdupq_n_f64(samplerZ_exp_coef[12]);
+        for(int i = 11; i >= 0; i--){
+            e = vfmaq_f64(vdupq_n_f64(samplerZ_exp_coef[i]), e, f);
+        }
+        t = vreinterpretq_f64_s64(vshlq_n_s64(vaddq_s64(ki, vdupq_n_s64(1023)), 52));
+        vst1q_f64(p + j, vmulq_f64(e, t));
+    }
+
+}
+
+#endif
+
+// Streams the N centers of src through MITAKA_SAMPLERZ_BATCH lanes: a lane
+// that accepts writes its sample and moves on to the next pending center.
+// Lanes past the last center point to the dummy slot N and never count.
+// cf holds floor(c), taken once per center instead of once per trial.
+static
+void samplerZ_stream(int32_t *res, const double *c, const int32_t *cf, int use_avx2){
+
+    uint64_t rnd[2 * MITAKA_SAMPLERZ_BATCH];
+    uint64_t r[MITAKA_SAMPLERZ_BATCH], ra[MITAKA_SAMPLERZ_BATCH];
+    int32_t idx[MITAKA_SAMPLERZ_BATCH], zc[MITAKA_SAMPLERZ_BATCH];
+    int32_t z0, b, z, acc, next, remaining;
+    double x[MITAKA_SAMPLERZ_BATCH], p[MITAKA_SAMPLERZ_BATCH];
+    double u;
+    uint8_t entropy;
+
+    for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j++){
+        idx[j] = j;
+    }
+    next = MITAKA_SAMPLERZ_BATCH;
+    remaining = N;
+
+    while(remaining){
+        entropy = get8();
+        get64_bulk(rnd, 2 * MITAKA_SAMPLERZ_BATCH);
+        for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j++){
+            r[j] = rnd[2 * j];
+            ra[j] = rnd[2 * j + 1];
+        }
+        for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j++){
+            u = c[idx[j]];
+            z0 = 0;
+            for(size_t i = 0; i < TABLE_SIZE; i++){
+                z0 += (r[j] >= CDT[i]);
+            }
+            b = (entropy >> j) & 1;
+            z = (2 * b - 1) * z0 + b + cf[idx[j]];
+            x[j] = ((double)(z0 * z0)-((double)(z - u) * (z - u))) / (2 * R_SQUARE);
+            zc[j] = z;
+        }
+
+#if MITAKA_SAMPLER_AVX2
+        if(use_avx2){
+            samplerZ_exp_batch_avx2(p, x);
+        }else{
+            samplerZ_exp_batch_portable(p, x);
+        }
+#elif MITAKA_SAMPLER_NEON
+        (void)use_avx2;
+        samplerZ_exp_batch_neon(p, x);
+#else
+        (void)use_avx2;
+        samplerZ_exp_batch_portable(p, x);
+#endif
+
+        for(size_t j = 0; j < MITAKA_SAMPLERZ_BATCH; j++){
+            // acc = -1 if lane j holds a pending center and accepts
+            acc = -(int32_t)((double)(ra[j] & 0x1FFFFFFFFFFFFFul) * 0x1p-53 < p[j]);
+            acc &= -(int32_t)(idx[j] < N);
+            res[idx[j]] = (res[idx[j]] & ~acc) | (zc[j] & acc);
+            remaining += acc;
+            z = next - ((next - N) & -(int32_t)(next > N));
+            idx[j] = (idx[j] & ~acc) | (z & acc);
+            next -= acc;
+        }
+    }
+
+}
+
+#if N % MITAKA_SAMPLERZ_BATCH != 0
+#error "N must be a multiple of MITAKA_SAMPLERZ_BATCH"
+#endif
+
+#if MITAKA_SAMPLERZ_BATCH > 8 || MITAKA_SAMPLERZ_BATCH % 4 != 0
+#error "MITAKA_SAMPLERZ_BATCH must be 4 or 8 (one sign bit of get8 per lane)"
+#endif
+
 void sample_discrete_gauss(poly *des, const fpoly *src){
+
+    int32_t res[N + 1], cf[N + 1];
+    double c[N + 1];
+    int use_avx2 = 0;
+
+#if MITAKA_SAMPLER_AVX2
+    use_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+
+    for(size_t i = 0; i <= N; i++){
+        c[i] = (i < N) ? src->coeffs[i].v : 0;
+        cf[i] = floor(c[i]);
+        res[i] = 0;
+    }
+
+    samplerZ_stream(res, c, cf, use_avx2);
+
+    for(size_t i = 0; i < N; i++){
+        des->coeffs[i] = res[i];
+    }
+
+}
+
+void sample_discrete_gauss_ref(poly *des, const fpoly *src){
     for(size_t i = 0; i < N; i++) {
         des->coeffs[i] = samplerZ(src->coeffs[i].v);
     }
 }
 
+// offline
+// we sample in FFT domain
+void sampler_perturbation(sign_perturbation *y, const sign_expanded_sk *sk){
+
+    normaldist(&y->FFTy1);
+    normaldist(&y->FFTy2);
+    fpoly_pointwise_mul(&y->FFTy1, &(sk->sigma1));
+    fpoly_pointwise_mul(&y->FFTy2, &(sk->sigma2));
+
+}
+
 // since c1 = 0, we don't need to pass its value
 // beta's and sigma's are all in FFT domain
-void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly c2){
+void sampler_online(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly c2,
+        const sign_perturbation *y){
 
     fpoly d, temp;
     fpoly FFTc2;
-    fpoly FFTy1, FFTy2;
     fpoly FFTv0, FFTv1;
 
     poly v0, v1;
@@ -125,20 +609,13 @@ void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly
     nc2 = c2;
     poly_neg(&nc2, &c2);
 
-    // offline
-    // we sample in FFT domain
-    normaldist(&FFTy1);
-    normaldist(&FFTy2);
-    fpoly_pointwise_mul(&FFTy1, &(sk->sigma1));
-    fpoly_pointwise_mul(&FFTy2, &(sk->sigma2));
-
     // online
     // first nearest plane
     poly_2_fpoly(&FFTc2, &nc2);
     fpoly_FFT(&FFTc2);
     d = FFTc2;
     fpoly_pointwise_mul(&d, &sk->beta21); //d2 fft form
-    fpoly_sub(&d, &FFTy2);
+    fpoly_sub(&d, &y->FFTy2);
     fpoly_iFFT(&d); // x2 = d2 - y2
 
     sample_discrete_gauss(&_d, &d);
@@ -160,7 +637,7 @@ void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly
     fpoly_pointwise_mul(&temp, &sk->beta10);
     fpoly_pointwise_mul(&d, &sk->beta11);
     fpoly_sub(&d, &temp); //d1 fft form
-    fpoly_sub(&d, &FFTy1);
+    fpoly_sub(&d, &y->FFTy1);
     fpoly_iFFT(&d); // x1 = d1 - y1
 
     sample_discrete_gauss(&_d, &d);
@@ -179,3 +656,69 @@ void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly
 
 }
 
+void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly c2){
+
+    sign_perturbation y;
+
+    sampler_perturbation(&y, sk);
+    sampler_online(v0_ptr, v1_ptr, sk, c2, &y);
+
+}
+
+// ================
+// Perturbation pool.
+
+static
+void perturbation_zeroize(sign_perturbation *y){
+    volatile uint8_t *p = (volatile uint8_t*)y;
+    for(size_t i = 0; i < sizeof(sign_perturbation); i++){
+        p[i] = 0;
+    }
+}
+
+void sign_perturbation_pool_init(sign_perturbation_pool *pool, const sign_expanded_sk *sk,
+        sign_perturbation *samples, size_t capacity){
+
+    pool->sk = sk;
+    pool->samples = samples;
+    pool->capacity = capacity;
+    pool->count = 0;
+
+}
+
+size_t sign_perturbation_pool_refill(sign_perturbation_pool *pool, size_t n){
+
+    size_t added = 0;
+
+    while((added < n) && (pool->count < pool->capacity)){
+        sampler_perturbation(pool->samples + pool->count, pool->sk);
+        pool->count++;
+        added++;
+    }
+
+    return added;
+
+}
+
+int sign_perturbation_pool_take(sign_perturbation *y, sign_perturbation_pool *pool){
+
+    if(pool->count == 0){
+        return 0;
+    }
+
+    pool->count--;
+    *y = pool->samples[pool->count];
+    perturbation_zeroize(pool->samples + pool->count);
+
+    return 1;
+
+}
+
+void sign_perturbation_pool_release(sign_perturbation_pool *pool){
+
+    for(size_t i = 0; i < pool->count; i++){
+        perturbation_zeroize(pool->samples + i);
+    }
+    pool->count = 0;
+
+}
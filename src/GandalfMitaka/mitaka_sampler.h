@@ -2,16 +2,35 @@
 #define MITAKA_SAMPLER_H
 
 #define TABLE_SIZE 13
+#define MITAKA_SAMPLERZ_BATCH (8)
 
 #include "rsig_params.h"
 
 extern
 uint64_t CDT[TABLE_SIZE];
 
+// normaldist runs the AVX2/FMA or NEON kernel when available and
+// normaldist_ref (libm) otherwise; both draw the same randomness.
 void normaldist(fpoly *vec);
+void normaldist_ref(fpoly *vec);
+// Largest relative density error, |r'^2 - r^2| / N for each pair, the
+// kernels may add over normaldist_ref (derivation in mitaka_sampler.c).
+#define NORMALDIST_DENSITY_ERROR_BOUND (0x1p-46)
 int samplerZ(double u);
+// sample_discrete_gauss runs samplerZ on MITAKA_SAMPLERZ_BATCH centers at a
+// time; sample_discrete_gauss_ref calls samplerZ on each coefficient. Both
+// have the same output distribution but consume randomness differently.
 void sample_discrete_gauss(poly *des, const fpoly *src);
+void sample_discrete_gauss_ref(poly *des, const fpoly *src);
+// sampler_perturbation is the offline part of sampler (y1, y2 in FFT
+// domain) and sampler_online the nearest-plane part that consumes it.
+void sampler_perturbation(sign_perturbation *y, const sign_expanded_sk *sk);
+void sampler_online(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly c2,
+        const sign_perturbation *y);
 void sampler(poly *v0_ptr, poly *v1_ptr, const sign_expanded_sk *sk, const poly c2);
+// Moves the most recent sample out of the pool and clears its slot.
+// Returns 0 when the pool is empty.
+int sign_perturbation_pool_take(sign_perturbation *y, sign_perturbation_pool *pool);
 
 #endif
 
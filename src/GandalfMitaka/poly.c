@@ -547,6 +547,11 @@ void poly_basemul2_generic(poly *des, const poly *src1, const poly *src2, ZArith
     }
 }
 
+// ================
+// SIMD NTT
+
+#include "poly_ntt_simd.c"
+
 // ================
 // polynomial multiplication
 
@@ -554,6 +559,24 @@ void poly_mul(poly *des, const poly *src1, const poly *src2){
 
     poly NTT1, NTT2;
 
+    NTT1 = *src1;
+    NTT2 = *src2;
+
+    poly_NTT(&NTT1);
+    poly_NTT(&NTT2);
+
+    poly_point_mul(&NTT1, &NTT1, &NTT2);
+
+    poly_iNTT(&NTT1);
+
+    *des = NTT1;
+
+}
+
+void poly_mul_ref(poly *des, const poly *src1, const poly *src2){
+
+    poly NTT1, NTT2;
+
     const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
 
     NTT1 = *src1;
@@ -570,6 +593,20 @@ void poly_mul(poly *des, const poly *src1, const poly *src2){
 
 }
 
+void poly_mul_NTT(poly *des, const poly *src1, const poly *src2_NTT){
+
+    poly NTT1;
+
+    NTT1 = *src1;
+
+    poly_NTT(&NTT1);
+    poly_point_mul(&NTT1, &NTT1, src2_NTT);
+    poly_iNTT(&NTT1);
+
+    *des = NTT1;
+
+}
+
 // WARNING: This is not constant-time.
 // Please ensure that the inputs are independent from the sensitive data.
 bool poly_test_inv(const poly src){
@@ -14,66 +14,106 @@
 static
 int Gandalf_signature_check_norm(const poly u[RING_K], const poly v){
 
-    int32_t acc;
+    // GANDALF_BOUND_SQUARE_FLOOR for rings of two, larger for RING_K > 2.
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(RING_K);
+    int64_t acc;
 
     acc = 0;
 
     for(size_t i = 0; i < RING_K; i++){
         for(size_t j = 0; j < N; j++){
-            acc += u[i].coeffs[j] * u[i].coeffs[j];
-            if(acc >= GANDALF_BOUND_SQUARE_FLOOR + 1){
-                acc = GANDALF_BOUND_SQUARE_FLOOR + 1;
+            acc += (int64_t)u[i].coeffs[j] * u[i].coeffs[j];
+            if(acc >= bound + 1){
+                acc = bound + 1;
             }
         }
     }
 
     for(size_t j = 0; j < N; j++){
-        acc += v.coeffs[j] * v.coeffs[j];
-        if(acc >= GANDALF_BOUND_SQUARE_FLOOR + 1){
-            acc = GANDALF_BOUND_SQUARE_FLOOR + 1;
+        acc += (int64_t)v.coeffs[j] * v.coeffs[j];
+        if(acc >= bound + 1){
+            acc = bound + 1;
         }
     }
 
-    return acc <= GANDALF_BOUND_SQUARE_FLOOR;
+    return acc <= bound;
 
 }
 
-void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
-        const rsig_pk *pks, const sign_expanded_sk *expanded_sk, size_t party_id){
+void sign_pk_to_ntt(sign_pk_ntt *des, const sign_pk *pk){
+
+    des->pk = *pk;
+    unpack_h(&des->h_NTT, &pk->h[0]);
+    poly_NTT(&des->h_NTT);
+
+}
+
+void Gandalf_prepare_pk(rsig_pk_prepared *prepared, const rsig_pk *pks){
+
+    prepared->pks = *pks;
+
+    for(size_t i = 0; i < RING_K; i++){
+        unpack_h(prepared->h_NTT + i, &(pks->hs[i]).h[0]);
+        poly_NTT(prepared->h_NTT + i);
+    }
+
+    hash_ring_init(&prepared->ring_state);
+    shake128_inc_absorb(&prepared->ring_state, (uint8_t*)&prepared->pks, RSIG_PUBLICKEY_BYTES);
+
+}
+
+void Gandalf_prepare_pk_ntt(rsig_pk_prepared *prepared, const sign_pk_ntt *members[RING_K]){
+
+    for(size_t i = 0; i < RING_K; i++){
+        prepared->pks.hs[i] = members[i]->pk;
+        prepared->h_NTT[i] = members[i]->h_NTT;
+    }
+
+    hash_ring_init(&prepared->ring_state);
+    shake128_inc_absorb(&prepared->ring_state, (uint8_t*)&prepared->pks, RSIG_PUBLICKEY_BYTES);
+
+}
 
-    poly hash, h_poly;
-    poly v, acc;
+// Takes the perturbation of each attempt from pool when it is not NULL
+// and not empty, and samples it inline otherwise.
+static
+void Gandalf_sign_core(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_expanded_sk *expanded_sk,
+        sign_perturbation_pool *pool, size_t party_id){
+
+    poly hash;
+    poly v, prod, acc;
     poly u[RING_K];
     poly c[RING_K];
+    sign_perturbation y;
 
     uint8_t salt[SALT_BYTES];
-    shake128incctx state;
 
     do {
 
         randombytes(salt, SALT_BYTES);
+        hash_ring_to_poly(&hash, &pks->ring_state, m, mlen, salt);
 
-        shake128_inc_init(&state);
-        shake128_inc_absorb(&state, (uint8_t*)m, mlen);
-        shake128_inc_absorb(&state, (uint8_t*)pks, RSIG_PUBLICKEY_BYTES);
-        shake128_inc_absorb(&state, (uint8_t*)salt, SALT_BYTES);
-        shake128_inc_finalize(&state);
-        hash_to_poly(&hash, &state);
-
+        // sum_{i != party_id} h[i] * u[i], with a single inverse transform.
         memset(&acc, 0, sizeof(acc));
         for(size_t i = 0; i < RING_K; i++){
             if(i == party_id)
                 continue;
             Gandalf_sample_poly(u + i);
-            unpack_h(&h_poly, &(pks->hs[i]).h[0]);
-            poly_mul(c + i, u + i, &h_poly);
-            poly_add(&acc, &acc, c + i);
+            prod = u[i];
+            poly_NTT(&prod);
+            poly_point_mul(&prod, &prod, pks->h_NTT + i);
+            poly_add(&acc, &acc, &prod);
         }
+        poly_iNTT(&acc);
 
         poly_sub(c + party_id, &hash, &acc);
         poly_freeze(c + party_id, c + party_id);
 
-        sampler(u + party_id, &v, expanded_sk, c[party_id]);
+        if((pool == NULL) || (sign_perturbation_pool_take(&y, pool) == 0)){
+            sampler_perturbation(&y, expanded_sk);
+        }
+        sampler_online(u + party_id, &v, expanded_sk, c[party_id], &y);
 
     } while(Gandalf_signature_check_norm(u, v) == 0);
 
@@ -87,6 +127,50 @@ void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t
 
 }
 
+void Gandalf_sign_prepared_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    Gandalf_sign_core(s, m, mlen, pks, expanded_sk, NULL, party_id);
+
+}
+
+void Gandalf_sign_prepared_pool(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, sign_perturbation_pool *pool, size_t party_id){
+
+    Gandalf_sign_core(s, m, mlen, pks, pool->sk, pool, party_id);
+
+}
+
+void Gandalf_sign_pool(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, sign_perturbation_pool *pool, size_t party_id){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+    Gandalf_sign_prepared_pool(s, m, mlen, &prepared, pool, party_id);
+
+}
+
+void Gandalf_sign_expanded_sk(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+    Gandalf_sign_prepared_expanded_sk(s, m, mlen, &prepared, expanded_sk, party_id);
+
+}
+
+void Gandalf_sign_prepared(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk_prepared *pks, const sign_sk *sk, size_t party_id){
+
+    sign_expanded_sk expanded_sk;
+
+    expand_sign_sk(&expanded_sk, sk);
+    Gandalf_sign_prepared_expanded_sk(s, m, mlen, pks, &expanded_sk, party_id);
+
+}
+
 void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
         const rsig_pk *pks, const sign_sk *sk, size_t party_id){
 
@@ -97,28 +181,40 @@ void Gandalf_sign(rsig_signature *s, const uint8_t *m, const size_t mlen,
 
 }
 
-int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks){
+// Gandalf_sign draws from the samplers all the way down, so ctx is made the
+// thread's context for the call and the previous one put back.
+void Gandalf_sign_ctx(rsig_signature *s, const uint8_t *m, const size_t mlen,
+        const rsig_pk *pks, const sign_sk *sk, size_t party_id, prng *ctx){
+
+    prng *prev = set_prng_ctx(ctx);
+
+    Gandalf_sign(s, m, mlen, pks, sk, party_id);
+    set_prng_ctx(prev);
+
+}
 
-    poly v, h_poly;
+int Gandalf_verify_prepared(const uint8_t *m, const size_t mlen, const rsig_signature *s,
+        const rsig_pk_prepared *pks){
+
+    poly v;
     poly prod, acc;
     poly u[RING_K];
 
-    shake128incctx state;
-
-    shake128_inc_init(&state);
-    shake128_inc_absorb(&state, (uint8_t*)m, mlen);
-    shake128_inc_absorb(&state, (uint8_t*)pks, RSIG_PUBLICKEY_BYTES);
-    shake128_inc_absorb(&state, (uint8_t*)s->salt, SALT_BYTES);
-    shake128_inc_finalize(&state);
-    hash_to_poly(&v, &state);
+    hash_ring_to_poly(&v, &pks->ring_state, m, mlen, s->salt);
 
+    // sum_i h[i] * u[i] is accumulated in the NTT domain, with a single
+    // inverse transform at the end. Each point product is below Q in
+    // absolute value, so the sum stays well inside the int32_t range the
+    // unreduced iNTT layers can absorb.
     memset(&acc, 0, sizeof(acc));
     for(size_t i = 0; i < RING_K; i++){
-        unpack_h(&h_poly, &(pks->hs[i]).h[0]);
         decompress_u_to_poly(u[i].coeffs, &s->compressed_sign[i]);
-        poly_mul(&prod, &u[i], &h_poly);
+        prod = u[i];
+        poly_NTT(&prod);
+        poly_point_mul(&prod, &prod, pks->h_NTT + i);
         poly_add(&acc, &acc, &prod);
     }
+    poly_iNTT(&acc);
 
     poly_sub(&v, &v, &acc);
     poly_freeze(&v, &v);
@@ -127,3 +223,141 @@ int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s,
 
 }
 
+int Gandalf_verify(const uint8_t *m, const size_t mlen, const rsig_signature *s, const rsig_pk *pks){
+
+    rsig_pk_prepared prepared;
+
+    Gandalf_prepare_pk(&prepared, pks);
+
+    return Gandalf_verify_prepared(m, mlen, s, &prepared);
+
+}
+
+// ================
+// Rings of k members chosen at run time.
+
+// Ring state of H(version || members[0].pk || ... || members[k - 1].pk || m || salt),
+// with the public keys streamed into SHAKE128 one member at a time.
+static
+void Gandalf_ring_state_k(shake128incctx *ring_state, const sign_pk_ntt *const *members, size_t k){
+
+    hash_ring_init(ring_state);
+    for(size_t i = 0; i < k; i++){
+        shake128_inc_absorb(ring_state, (uint8_t*)&members[i]->pk, SIGN_PUBLICKEY_BYTES);
+    }
+
+}
+
+// Adds the squared norm of src to acc, saturating at bound + 1.
+static
+int64_t Gandalf_norm_add_k(int64_t acc, const poly *src, int64_t bound){
+
+    for(size_t j = 0; j < N; j++){
+        acc += (int64_t)src->coeffs[j] * src->coeffs[j];
+    }
+
+    return (acc > bound) ? (bound + 1) : acc;
+
+}
+
+// Non-signer members are compressed into s as soon as they are sampled, so
+// a single u is live at a time whatever the ring size.
+static
+void Gandalf_sign_k_core(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    poly hash;
+    poly u, v, prod, acc;
+    int64_t norm;
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(k);
+    uint8_t *salt = s + k * COMPRESSED_SIGN_SIGNATURE_BYTES;
+    shake128incctx ring_state;
+
+    assert(party_id < k);
+
+    // The ring is absorbed once; each attempt only absorbs m and the salt.
+    Gandalf_ring_state_k(&ring_state, members, k);
+
+    do {
+
+        randombytes(salt, SALT_BYTES);
+        hash_ring_to_poly(&hash, &ring_state, m, mlen, salt);
+
+        norm = 0;
+        memset(&acc, 0, sizeof(acc));
+        for(size_t i = 0; i < k; i++){
+            if(i == party_id)
+                continue;
+            Gandalf_sample_poly(&u);
+            norm = Gandalf_norm_add_k(norm, &u, bound);
+            compress_u_from_poly(s + i * COMPRESSED_SIGN_SIGNATURE_BYTES, u.coeffs);
+            prod = u;
+            poly_NTT(&prod);
+            poly_point_mul(&prod, &prod, &members[i]->h_NTT);
+            poly_add(&acc, &acc, &prod);
+        }
+        poly_iNTT(&acc);
+
+        // hash <- c[party_id] = hash - sum_{i != party_id} h[i] * u[i]
+        poly_sub(&hash, &hash, &acc);
+        poly_freeze(&hash, &hash);
+
+        sampler(&u, &v, expanded_sk, hash);
+
+        norm = Gandalf_norm_add_k(norm, &u, bound);
+        norm = Gandalf_norm_add_k(norm, &v, bound);
+
+    } while(norm > bound);
+
+    compress_u_from_poly(s + party_id * COMPRESSED_SIGN_SIGNATURE_BYTES, u.coeffs);
+
+}
+
+void Gandalf_sign_k_expanded_sk(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_expanded_sk *expanded_sk, size_t party_id){
+
+    Gandalf_sign_k_core(s, m, mlen, members, k, expanded_sk, party_id);
+
+}
+
+void Gandalf_sign_k(uint8_t *s, const uint8_t *m, const size_t mlen,
+        const sign_pk_ntt *const *members, size_t k, const sign_sk *sk, size_t party_id){
+
+    sign_expanded_sk expanded_sk;
+
+    expand_sign_sk(&expanded_sk, sk);
+    Gandalf_sign_k_expanded_sk(s, m, mlen, members, k, &expanded_sk, party_id);
+
+}
+
+int Gandalf_verify_k(const uint8_t *m, const size_t mlen, const uint8_t *s,
+        const sign_pk_ntt *const *members, size_t k){
+
+    poly u, v, prod, acc;
+    int64_t norm;
+    const int64_t bound = GANDALF_BOUND_SQUARE_FLOOR_K(k);
+    shake128incctx ring_state;
+
+    Gandalf_ring_state_k(&ring_state, members, k);
+    hash_ring_to_poly(&v, &ring_state, m, mlen, s + k * COMPRESSED_SIGN_SIGNATURE_BYTES);
+
+    norm = 0;
+    memset(&acc, 0, sizeof(acc));
+    for(size_t i = 0; i < k; i++){
+        decompress_u_to_poly(u.coeffs, s + i * COMPRESSED_SIGN_SIGNATURE_BYTES);
+        norm = Gandalf_norm_add_k(norm, &u, bound);
+        prod = u;
+        poly_NTT(&prod);
+        poly_point_mul(&prod, &prod, &members[i]->h_NTT);
+        poly_add(&acc, &acc, &prod);
+    }
+    poly_iNTT(&acc);
+
+    poly_sub(&v, &v, &acc);
+    poly_freeze(&v, &v);
+    norm = Gandalf_norm_add_k(norm, &v, bound);
+
+    return norm <= bound;
+
+}
+
@@ -12,6 +12,27 @@
 // #define R_SQUARE 1.7424
 #define GANDALF_BOUND_SQUARE_FLOOR (60669689)
 
+// Norm bound of a ring of k members. A signature is k + 1 polynomials
+// (u[0], ..., u[k - 1], v) of N coefficients each, and every coefficient
+// follows a discrete Gaussian of standard deviation GANDALF_SIGMA: the
+// non-signers' u[i] are drawn from Gandalf_table, whose width is taken
+// equal to the trapdoor sampler's so that the signer's (u[party_id], v)
+// look the same (see samplerZ_table.c). The squared bound is
+//     tau^2 * GANDALF_SIGMA^2 * (k + 1) * N,
+// and GANDALF_BOUND_SQUARE_FLOOR above is its value for k = 2 with
+// tau^2 = GANDALF_TAU_SQUARE = 1.22^2. By [Lyu12, Lemma 4.4] an honest
+// signature exceeds it with probability below
+//     (tau * exp((1 - tau^2) / 2))^((k + 1) * N),
+// which only decreases as k grows. The forgery bound grows with
+// sqrt(k + 1); the security estimate of the parameter set covers k = 2.
+// [Lyu12] V. Lyubashevsky, Lattice Signatures without Trapdoors,
+//         EUROCRYPT 2012.
+#define GANDALF_SIGMA 162.90351261574722
+#define GANDALF_SIGMA_SQUARE (GANDALF_SIGMA * GANDALF_SIGMA)
+#define GANDALF_TAU_SQUARE 1.4884
+#define GANDALF_BOUND_SQUARE_FLOOR_K(k) \
+    ((int64_t)(GANDALF_TAU_SQUARE * GANDALF_SIGMA_SQUARE * N * (double)((k) + 1)))
+
 // #define SALT_BYTES 24
 #define ZQPOLY_BYTES (2 * N)
 #define FPOLY_BYTES (8 * N)
@@ -1,8 +1,12 @@
 
+#include "rsig_params.h"
 #include "rsig_api.h"
 #include "mitaka_keygen.h"
 #include "mitaka_sign.h"
 #include "randombytes.h"
+#include "gandalf_samplerZ.h"
+#include "poly.h"
+#include "mitaka_sampler.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -24,8 +28,24 @@ int main(){
   sign_signature s;
   rsig_pk pks;
   rsig_signature Gandalf_s;
+  poly u, u_ref, v, v_NTT;
+  double sum[2], sum2[2], mean[2], var[2];
+  static rsig_pk_prepared prepared, prepared_ntt;
+  static sign_expanded_sk expanded_sk;
+  static sign_perturbation pool_samples[8];
+  static const sign_perturbation zero_perturbation;
+  sign_perturbation_pool pool;
+  size_t pool_count;
+  static sign_pk_ntt pk_ntt[16];
+  const sign_pk_ntt *members[16];
+  static uint8_t Gandalf_s_k[RSIG_SIGNATURE_BYTES_K(16)];
+  size_t ring_k;
   size_t party_id;
   int correct;
+  static fpoly y, y_ref;
+  double err, max_err, pos_err, max_pos_err, r2, r2_ref;
+  static uint64_t hist[2][33];
+  double chi2;
 
   uint8_t m[MAXMBYTES] = {0x46,0xb6,0xc4,0x83,0x3f,0x61,0xfa,0x3e,0xaa,0xe9,0xad,0x4a,0x68,0x8c,0xd9,0x6e,0x22,0x6d,0x93,0x3e,0xde,0xc4,0x64,0x9a,0xb2,0x18,0x45,0x2,0xad,0xf3,0xc,0x61};
 
@@ -113,6 +133,237 @@ int main(){
     (correct == 0)?"ok":"ERROR!");
 
 
+  printf("* Test Gandalf_prepare_pk_ntt against Gandalf_prepare_pk.\n");
+
+  for(size_t i = 0; i < 16; i++){
+    sign_pk_to_ntt(pk_ntt + i, pk + i);
+    members[i] = pk_ntt + i;
+  }
+  Gandalf_prepare_pk(&prepared, &pks);
+  Gandalf_prepare_pk_ntt(&prepared_ntt, members);
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    randombytes(m, MIN(i, MAXMBYTES));
+    party_id = rand() % RING_K;
+    Gandalf_sign_prepared(&Gandalf_s, m, MIN(i, MAXMBYTES), &prepared_ntt, sk + party_id, party_id);
+    correct += Gandalf_verify_prepared(m, MIN(i, MAXMBYTES), &Gandalf_s, &prepared_ntt);
+    Gandalf_s.salt[0] ^= 1;
+    correct -= Gandalf_verify_prepared(m, MIN(i, MAXMBYTES), &Gandalf_s, &prepared_ntt);
+  }
+  printf("  identical prepared rings: %s, %d/%d correct signatures. (%s).\n\n",
+	  (memcmp(&prepared, &prepared_ntt, sizeof(rsig_pk_prepared)) == 0)?"yes":"no", correct, ITERATIONS,
+	  (correct == ITERATIONS && memcmp(&prepared, &prepared_ntt, sizeof(rsig_pk_prepared)) == 0)?"ok":"ERROR!");
+
+  printf("* Test Gandalf_sign_pool.\n");
+
+  // The pool is refilled by 4 every other signature, so it also runs
+  // empty; every sample taken must leave a cleared slot behind.
+  expand_sign_sk(&expanded_sk, sk + 0);
+  sign_perturbation_pool_init(&pool, &expanded_sk, pool_samples, 8);
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    if(i % 2 == 0){
+      sign_perturbation_pool_refill(&pool, 4);
+    }
+    pool_count = pool.count;
+    randombytes(m, MIN(i, MAXMBYTES));
+    Gandalf_sign_pool(&Gandalf_s, m, MIN(i, MAXMBYTES), &pks, &pool, 0);
+    correct += Gandalf_verify(m, MIN(i, MAXMBYTES), &Gandalf_s, &pks) &&
+               ((pool_count == 0) ||
+                ((pool.count < pool_count) &&
+                 (memcmp(pool_samples + pool.count, &zero_perturbation, sizeof(sign_perturbation)) == 0)));
+  }
+  sign_perturbation_pool_release(&pool);
+  printf("  %d/%d correct signatures. (%s).\n\n", correct, ITERATIONS,
+	  (correct == ITERATIONS && pool.count == 0)?"ok":"ERROR!");
+
+  printf("* Test Gandalf_sign_k and Gandalf_verify_k.\n");
+
+  // A ring of RING_K members gives the same signatures as Gandalf_sign
+  // from the same PRNG state. The encoder may leave trailing bytes of each
+  // compressed u untouched, so both buffers start cleared.
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    party_id = rand() % RING_K;
+    for(size_t j = 0; j < 32; j++){
+      m[j] = (uint8_t)rand();
+    }
+    memset(&Gandalf_s, 0, sizeof(rsig_signature));
+    memset(Gandalf_s_k, 0, sizeof(rsig_signature));
+    init_prng();
+    Gandalf_sign(&Gandalf_s, m, 32, &pks, sk + party_id, party_id);
+    init_prng();
+    Gandalf_sign_k(Gandalf_s_k, m, 32, members, RING_K, sk + party_id, party_id);
+    correct += (memcmp(&Gandalf_s, Gandalf_s_k, sizeof(rsig_signature)) == 0) &&
+               Gandalf_verify_k(m, 32, Gandalf_s_k, members, RING_K);
+  }
+  seed_rng();
+  printf("  %d/%d identical signatures. (%s).\n", correct, ITERATIONS,
+	  (correct == ITERATIONS)?"ok":"ERROR!");
+
+  // Rings of 1 to 16 members; a flipped salt bit must be rejected.
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    ring_k = 1 + i % 16;
+    party_id = rand() % ring_k;
+    randombytes(m, MIN(i, MAXMBYTES));
+    Gandalf_sign_k(Gandalf_s_k, m, MIN(i, MAXMBYTES), members, ring_k, sk + party_id, party_id);
+    correct += Gandalf_verify_k(m, MIN(i, MAXMBYTES), Gandalf_s_k, members, ring_k);
+    Gandalf_s_k[RSIG_SIGNATURE_BYTES_K(ring_k) - 1] ^= 1;
+    correct -= Gandalf_verify_k(m, MIN(i, MAXMBYTES), Gandalf_s_k, members, ring_k);
+  }
+  printf("  %d/%d correct signatures. (%s).\n\n", correct, ITERATIONS,
+	  (correct == ITERATIONS)?"ok":"ERROR!");
+
+  printf("* Test the norm bound of rings of k members.\n");
+
+  // GANDALF_BOUND_SQUARE_FLOOR_K is derived from the width of the member
+  // Gaussians: for k = 2 it gives back the bound of the parameter set, and
+  // Gandalf_sample_poly has that width.
+  sum2[0] = 0;
+  for(size_t i = 0; i < 256; i++) {
+    Gandalf_sample_poly(&u);
+    for(size_t j = 0; j < N; j++){
+      sum2[0] += (double)u.coeffs[j] * u.coeffs[j];
+    }
+  }
+  var[0] = sum2[0] / (256 * N);
+  correct = (GANDALF_BOUND_SQUARE_FLOOR_K(2) == GANDALF_BOUND_SQUARE_FLOOR) &&
+            (fabs(var[0] / GANDALF_SIGMA_SQUARE - 1) < 0.02);
+  printf("  variance %.1f, expected %.1f. (%s).\n\n", var[0], GANDALF_SIGMA_SQUARE,
+	  correct?"ok":"ERROR!");
+
+  printf("* Test Gandalf_sample_poly against Gandalf_sample_poly_ref.\n");
+
+  // Same PRNG state, shifted by i words so that batches start at every offset.
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    init_prng();
+    for(size_t j = 0; j < i; j++){
+      get64();
+    }
+    Gandalf_sample_poly(&u);
+    init_prng();
+    for(size_t j = 0; j < i; j++){
+      get64();
+    }
+    Gandalf_sample_poly_ref(&u_ref);
+    correct += (memcmp(&u, &u_ref, sizeof(poly)) == 0);
+  }
+  seed_rng();
+  printf("  %d/%d identical polynomials. (%s).\n", correct, ITERATIONS,
+	  (correct == ITERATIONS)?"ok":"ERROR!");
+
+  // Independent streams: the first two moments of both samplers must agree.
+  for(size_t k = 0; k < 2; k++) {
+    sum[k] = sum2[k] = 0;
+    for(size_t i = 0; i < ITERATIONS; i++) {
+      if(k == 0){
+        Gandalf_sample_poly(&u);
+      }else{
+        Gandalf_sample_poly_ref(&u);
+      }
+      for(size_t j = 0; j < N; j++){
+        sum[k] += u.coeffs[j];
+        sum2[k] += (double)u.coeffs[j] * u.coeffs[j];
+      }
+    }
+    mean[k] = sum[k] / ((double)ITERATIONS * N);
+    var[k] = sum2[k] / ((double)ITERATIONS * N) - mean[k] * mean[k];
+  }
+  printf("  mean %.3f / %.3f, variance %.1f / %.1f. (%s).\n\n", mean[0], mean[1], var[0], var[1],
+	  (fabs(mean[0] - mean[1]) < 1.0 && fabs(var[0] / var[1] - 1.0) < 0.01)?"ok":"ERROR!");
+
+  printf("* Test poly_mul against poly_mul_ref.\n");
+
+  // Operands up to 2^(12 + i % 10) in absolute value.
+  correct = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    for(size_t j = 0; j < N; j++){
+      u.coeffs[j] = (int32_t)(get64() % (2 << (12 + i % 10))) - (1 << (12 + i % 10));
+      v.coeffs[j] = (int32_t)(get64() % (2 << (12 + i % 10))) - (1 << (12 + i % 10));
+    }
+    poly_mul_ref(&u_ref, &u, &v);
+    v_NTT = v;
+    poly_NTT(&v_NTT);
+    poly_mul_NTT(&v_NTT, &u, &v_NTT);
+    poly_mul(&u, &u, &v);
+    correct += (memcmp(&u, &u_ref, sizeof(poly)) == 0) && (memcmp(&v_NTT, &u_ref, sizeof(poly)) == 0);
+  }
+  printf("  %d/%d identical products. (%s).\n\n", correct, ITERATIONS,
+	  (correct == ITERATIONS)?"ok":"ERROR!");
+
+  printf("* Test normaldist against normaldist_ref.\n");
+
+  // Same PRNG state, shifted by i words so that every vector differs. Each
+  // pair must have a relative density error |r'^2 - r^2| / N of at most
+  // NORMALDIST_DENSITY_ERROR_BOUND, the share of the perturbation sampler's
+  // Renyi budget left to the kernels, and coordinates within the same bound
+  // of libm relative to its radius, so that the angle matches as well.
+  correct = 0;
+  max_err = 0;
+  max_pos_err = 0;
+  for(size_t i = 0; i < ITERATIONS; i++) {
+    init_prng();
+    for(size_t j = 0; j < i; j++){
+      get64();
+    }
+    normaldist(&y);
+    init_prng();
+    for(size_t j = 0; j < i; j++){
+      get64();
+    }
+    normaldist_ref(&y_ref);
+    err = 0;
+    pos_err = 0;
+    for(size_t j = 0; j < N; j += 2){
+      r2 = y.coeffs[j].v * y.coeffs[j].v + y.coeffs[j + 1].v * y.coeffs[j + 1].v;
+      r2_ref = y_ref.coeffs[j].v * y_ref.coeffs[j].v + y_ref.coeffs[j + 1].v * y_ref.coeffs[j + 1].v;
+      err = MAX(err, fabs(r2 - r2_ref) / N);
+      pos_err = MAX(pos_err, MAX(fabs(y.coeffs[j].v - y_ref.coeffs[j].v), fabs(y.coeffs[j + 1].v - y_ref.coeffs[j + 1].v))
+                             / sqrt(r2_ref));
+    }
+    max_err = MAX(max_err, err);
+    max_pos_err = MAX(max_pos_err, pos_err);
+    correct += (err <= NORMALDIST_DENSITY_ERROR_BOUND) && (pos_err <= NORMALDIST_DENSITY_ERROR_BOUND);
+  }
+  seed_rng();
+  printf("  %d/%d vectors within 2^%.0f (max density error 2^%.1f, max relative error 2^%.1f). (%s).\n\n", correct, ITERATIONS,
+	  log2(NORMALDIST_DENSITY_ERROR_BOUND), log2(max_err), log2(max_pos_err), (correct == ITERATIONS)?"ok":"ERROR!");
+
+  printf("* Test sample_discrete_gauss against sample_discrete_gauss_ref.\n");
+
+  // Centers sweep [-4, 4) with every fractional part; both samplers are
+  // histogrammed on z - floor(center) and compared with a two-sample
+  // chi-square statistic (about 25 populated bins).
+  for(size_t k = 0; k < 2; k++) {
+    sum[k] = sum2[k] = 0;
+    for(size_t i = 0; i < ITERATIONS; i++) {
+      for(size_t j = 0; j < N; j++){
+        y.coeffs[j].v = -4.0 + 8.0 * (double)i / ITERATIONS + (double)j / N;
+      }
+      if(k == 0){
+        sample_discrete_gauss(&u, &y);
+      }else{
+        sample_discrete_gauss_ref(&u, &y);
+      }
+      for(size_t j = 0; j < N; j++){
+        sum[k] += u.coeffs[j] - y.coeffs[j].v;
+        sum2[k] += (u.coeffs[j] - y.coeffs[j].v) * (u.coeffs[j] - y.coeffs[j].v);
+        hist[k][MIN(MAX(u.coeffs[j] - (int32_t)floor(y.coeffs[j].v), -16), 16) + 16]++;
+      }
+    }
+    mean[k] = sum[k] / ((double)ITERATIONS * N);
+    var[k] = sum2[k] / ((double)ITERATIONS * N) - mean[k] * mean[k];
+  }
+  chi2 = 0;
+  for(size_t j = 0; j < 33; j++){
+    if(hist[0][j] + hist[1][j] > 0){
+      chi2 += ((double)hist[0][j] - hist[1][j]) * ((double)hist[0][j] - hist[1][j]) / (hist[0][j] + hist[1][j]);
+    }
+  }
+  printf("  mean %.4f / %.4f, variance %.4f / %.4f, chi-square %.1f. (%s).\n\n", mean[0], mean[1], var[0], var[1], chi2,
+	  (fabs(mean[0] - mean[1]) < 0.01 && fabs(var[0] / var[1] - 1.0) < 0.01 && chi2 < 80)?"ok":"ERROR!");
 
   return 0;
 }
@@ -4,6 +4,8 @@
 #include "scalarmult.h"
 #include "fips202.h"
 
+#include <string.h>
+
 void nike_akem_keygen(nike_sk *sk, nike_pk *pk){
     dh_keypair(sk->sk, pk->pk);
 }
@@ -19,13 +21,18 @@ void nike_akem_encap(uint8_t *k, nike_pk *ct,
 
     nike_sk e_nsk;
     nike_pk e_npk;
-    uint8_t k1[32], k2[32];
+    uint8_t n[64], p[64], k1k2[64];
+    uint8_t *k1 = k1k2, *k2 = k1k2 + 32;
     sha3_256incctx ctx;
 
     nike_keygen(&e_nsk, &e_npk);
 
-    scalarmult(k1, sender_sk->sk, receiver_pk->pk);
-    scalarmult(k2, e_nsk.sk, receiver_pk->pk);
+    // Both ladders share one inversion.
+    memcpy(n, sender_sk->sk, 32);
+    memcpy(n + 32, e_nsk.sk, 32);
+    memcpy(p, receiver_pk->pk, 32);
+    memcpy(p + 32, receiver_pk->pk, 32);
+    scalarmult_many(k1k2, n, p, 2);
 
     *ct = e_npk;
 
@@ -45,11 +52,16 @@ void nike_akem_encap(uint8_t *k, nike_pk *ct,
 void nike_akem_decap(uint8_t *k,
             const nike_pk *ct, const nike_sk *receiver_sk, const nike_pk *receiver_pk, const nike_pk *sender_pk){
 
-    uint8_t k1[32], k2[32];
+    uint8_t n[64], p[64], k1k2[64];
+    uint8_t *k1 = k1k2, *k2 = k1k2 + 32;
     sha3_256incctx ctx;
 
-    scalarmult(k1, receiver_sk->sk, sender_pk->pk);
-    scalarmult(k2, receiver_sk->sk, ct->pk);
+    // Both ladders share one inversion.
+    memcpy(n, receiver_sk->sk, 32);
+    memcpy(n + 32, receiver_sk->sk, 32);
+    memcpy(p, sender_pk->pk, 32);
+    memcpy(p + 32, ct->pk, 32);
+    scalarmult_many(k1k2, n, p, 2);
 
     sha3_256_inc_init(&ctx);
     sha3_256_inc_absorb(&ctx, dh_prefix, sizeof(dh_prefix));
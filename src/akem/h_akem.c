@@ -11,6 +11,12 @@ This file implements Figure 9 of our paper.
 
 #include <string.h>
 
+// The AKEM rings are [sender_pk, receiver_pk]; larger RING_K only applies to
+// the ring signature built on its own (make -C <rsig dir> test RING_K=k).
+#if RING_K != 2
+#error "The AKEMs need RING_K == 2"
+#endif
+
 static const uint8_t aes_iv[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
 // Function Gen.
@@ -21,64 +27,161 @@ void h_akem_keygen(h_akem_sk *sk, h_akem_pk *pk){
     nike_keygen(&sk->nsk, &pk->npk);
 }
 
-// Function Enc.
-void h_akem_encap(uint8_t *h_akem_k, h_akem_ct *ct,
-                              const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
-                              const h_akem_pk *receiver_pk){
+void h_akem_expand_sk(h_akem_expanded_sk *expanded_sk, const h_akem_sk *sk){
+    expanded_sk->sk = *sk;
+    expand_sign_sk(&expanded_sk->essk, &sk->ssk);
+}
+
+void h_akem_expanded_sk_release(h_akem_expanded_sk *expanded_sk){
+    volatile uint8_t *p = (volatile uint8_t*)expanded_sk;
+    for(size_t i = 0; i < sizeof(h_akem_expanded_sk); i++){
+        p[i] = 0;
+    }
+}
+
+// nk from nkprime: line 11 on the sender side, line 25 on the receiver side.
+static
+void h_akem_nk(uint8_t *nk, const nike_s *nkprime){
+
+    const uint8_t tag[4] = "auth";
+
+    hmac_sha3_256(nk, tag, sizeof(tag), nkprime->s);
+
+}
+
+// The ring [sender_pk, receiver_pk] of lines 15 and 31.
+static
+void h_akem_peer_ctx_set_ring(h_akem_peer_ctx *ctx,
+                              const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk){
 
-    kem_ct internal_kem_ct;
     rsig_pk internal_rsig_pk;
-    rsig_signature internal_signature;
-    nike_sk e_nsk;
-    nike_pk e_npk;
-    nike_s nk, nkprime, nk1k2;
+
+    internal_rsig_pk.hs[0] = sender_pk->spk;
+    internal_rsig_pk.hs[1] = receiver_pk->spk;
+    Gandalf_prepare_pk(&ctx->ring, &internal_rsig_pk);
+
+}
+
+// nk from nkprime, and the ring [sender_pk, receiver_pk].
+static
+void h_akem_peer_ctx_set(h_akem_peer_ctx *ctx, const nike_s *nkprime,
+                         const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk){
+
+    h_akem_nk(ctx->nk, nkprime);
+    h_akem_peer_ctx_set_ring(ctx, sender_pk, receiver_pk);
+
+}
+
+// Lines 10 ~ 11 and the ring of line 15, shared by every encapsulation
+// from sender_pk to receiver_pk.
+void h_akem_peer_ctx_init_sender(h_akem_peer_ctx *ctx,
+                                 const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                                 const h_akem_pk *receiver_pk){
+
+    nike_s nkprime;
+
+    nike_sdk(&nkprime, &sender_sk->nsk, &receiver_pk->npk);
+    h_akem_peer_ctx_set(ctx, &nkprime, sender_pk, receiver_pk);
+
+}
+
+// Lines 24 ~ 25 and the ring of line 31, shared by every decapsulation
+// from sender_pk to receiver_pk.
+void h_akem_peer_ctx_init_receiver(h_akem_peer_ctx *ctx,
+                                   const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                                   const h_akem_pk *sender_pk){
+
+    nike_s nkprime;
+
+    nike_sdk(&nkprime, &receiver_sk->nsk, &sender_pk->npk);
+    h_akem_peer_ctx_set(ctx, &nkprime, sender_pk, receiver_pk);
+
+}
+
+void h_akem_peer_ctx_release(h_akem_peer_ctx *ctx){
+    volatile uint8_t *nk = ctx->nk;
+    for(size_t i = 0; i < sizeof(ctx->nk); i++){
+        nk[i] = 0;
+    }
+}
+
+// Lines 9 ~ 12: the ephemeral key pair, with its public key in ct->npk,
+// and nk1k2. With sender_sk not NULL, ctx is also set up from the
+// static-static key of lines 10 ~ 11, and both ladders share one
+// inversion.
+static
+void h_akem_encap_dh(nike_s *nk1k2, h_akem_ct *ct, h_akem_peer_ctx *ctx,
+                     const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                     const h_akem_pk *receiver_pk){
+
+    nike_sk dh_sk[2];
+    nike_pk dh_pk[2];
+    nike_s dh_s[2];
+
+    nike_keygen(dh_sk, &ct->npk);
+    if(sender_sk == NULL){
+        nike_sdk(nk1k2, dh_sk, &receiver_pk->npk);
+        return;
+    }
+
+    dh_sk[1] = sender_sk->nsk;
+    dh_pk[0] = receiver_pk->npk;
+    dh_pk[1] = receiver_pk->npk;
+    nike_sdk_batch(dh_s, dh_sk, dh_pk, 2);
+    *nk1k2 = dh_s[0];
+    h_akem_peer_ctx_set(ctx, dh_s + 1, sender_pk, receiver_pk);
+
+}
+
+// Function Enc from line 13 on, with nk and the ring taken from ctx and
+// nk1k2 from h_akem_encap_dh. Line 15 signs with sender_essk when it is
+// not NULL, with sender_ssk otherwise.
+static
+void h_akem_encap_core(uint8_t *h_akem_k, h_akem_ct *ct,
+                       const sign_sk *sender_ssk, const sign_expanded_sk *sender_essk,
+                       const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk,
+                       const h_akem_peer_ctx *ctx, const nike_s *nk1k2){
+
     uint8_t k1k2[64];
     uint8_t hmac_nk2[32];
     uint8_t hmac_out[32];
     uint8_t kprime[32];
     uint8_t m[MLEN];
-    uint8_t enc_rsig[RSIG_SIGNATURE_BYTES];
-    const uint8_t tag[4] = "auth";
-    aes128ctx ctx;
+    aes128ctx_inline aes_ctx;
     sha3_256incctx hmac_state;
 
     uint8_t *k1 = k1k2;
     uint8_t *k2 = k1 + 32;
-    uint8_t *nk1 = nk1k2.s;
-    uint8_t *nk2 = nk1 + 32;
+    const uint8_t *nk1 = nk1k2->s;
+    const uint8_t *nk2 = nk1 + 32;
 
-    // Lines 9 ~ 12.
-    nike_keygen(&e_nsk, &e_npk);
-    nike_sdk(&nkprime, &sender_sk->nsk, &receiver_pk->npk);
-    hmac_sha3_256((uint8_t*)&nk.s, tag, sizeof(tag), nkprime.s);
-    nike_sdk(&nk1k2, &e_nsk, &receiver_pk->npk);
+    // The ephemeral key, the KEM ciphertext and the signature are produced
+    // in place in ct; the signature is then encrypted over itself.
 
     // Line 13.
-    kem_encap(k1k2, 64, &internal_kem_ct, &receiver_pk->kpk);
+    kem_encap(k1k2, 64, &ct->ct, &receiver_pk->kpk);
 
     // Line 14.
-    memmove(m, &internal_kem_ct, KEM_CIPHERTXT_BYTES);
+    memmove(m, &ct->ct, KEM_CIPHERTXT_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES, &receiver_pk->kpk, KEM_PUBLICKEY_BYTES);
 
     // Line 15.
-    internal_rsig_pk.hs[0] = sender_pk->spk;
-    internal_rsig_pk.hs[1] = receiver_pk->spk;
-    Gandalf_sign(&internal_signature, m, MLEN, &internal_rsig_pk, &sender_sk->ssk, 0);
+    if(sender_essk != NULL){
+        Gandalf_sign_prepared_expanded_sk((rsig_signature*)ct->enc_rsig, m, MLEN, &ctx->ring, sender_essk, 0);
+    }else{
+        Gandalf_sign_prepared((rsig_signature*)ct->enc_rsig, m, MLEN, &ctx->ring, sender_ssk, 0);
+    }
 
     // Line 16.
     hmac_sha3_256(kprime, k1, 32, nk1);
 
     // Line 17.
-    aes128_ctr_keyexp(&ctx, kprime);
-    aes128_ctr(enc_rsig, (void*)&internal_signature, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
-    aes128_ctx_release(&ctx);
+    aes128_ctr_keyexp_inline(&aes_ctx, kprime);
+    aes128_ctr_inplace_inline(ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &aes_ctx);
+    aes128_ctx_inline_release(&aes_ctx);
 
     // Line 18 ~ 19 below.
 
-    ct->npk = e_npk;
-    ct->ct = internal_kem_ct;
-    memmove(ct->enc_rsig, enc_rsig, RSIG_SIGNATURE_BYTES);
-
     hmac_sha3_256_inc_init(&hmac_state, k2);
     sha3_256_inc_absorb(&hmac_state, (const uint8_t*)ct, sizeof(h_akem_ct));
     sha3_256_inc_absorb(&hmac_state, (const uint8_t*)sender_pk, sizeof(h_akem_pk));
@@ -86,37 +189,71 @@ void h_akem_encap(uint8_t *h_akem_k, h_akem_ct *ct,
     hmac_sha3_256_inc_finalize(hmac_out, &hmac_state, k2);
     sha3_256_inc_ctx_release(&hmac_state);
 
-    hmac_sha3_256(hmac_nk2, nk2, 32, nk.s);
+    hmac_sha3_256(hmac_nk2, nk2, 32, ctx->nk);
     hmac_sha3_256(h_akem_k, hmac_out, 32, hmac_nk2);
 
 }
 
-// Function Dec.
-int h_akem_decap(uint8_t *h_akem_k, const h_akem_ct *ct,
-                 const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
-                 const h_akem_pk *sender_pk){
+void h_akem_encap_ctx(uint8_t *h_akem_k, h_akem_ct *ct,
+                      const h_akem_sk *sender_sk, const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk,
+                      const h_akem_peer_ctx *ctx){
+
+    nike_s nk1k2;
+
+    h_akem_encap_dh(&nk1k2, ct, NULL, NULL, sender_pk, receiver_pk);
+    h_akem_encap_core(h_akem_k, ct, &sender_sk->ssk, NULL, sender_pk, receiver_pk, ctx, &nk1k2);
+
+}
+
+// Function Enc.
+void h_akem_encap(uint8_t *h_akem_k, h_akem_ct *ct,
+                              const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                              const h_akem_pk *receiver_pk){
+
+    h_akem_peer_ctx ctx;
+    nike_s nk1k2;
+
+    h_akem_encap_dh(&nk1k2, ct, &ctx, sender_sk, sender_pk, receiver_pk);
+    h_akem_encap_core(h_akem_k, ct, &sender_sk->ssk, NULL, sender_pk, receiver_pk, &ctx, &nk1k2);
+    h_akem_peer_ctx_release(&ctx);
+
+}
+
+// Function Enc with the signing key of sender_sk already expanded.
+void h_akem_encap_expanded_sk(uint8_t *h_akem_k, h_akem_ct *ct,
+                              const h_akem_expanded_sk *sender_sk, const h_akem_pk *sender_pk,
+                              const h_akem_pk *receiver_pk){
+
+    h_akem_peer_ctx ctx;
+    nike_s nk1k2;
+
+    h_akem_encap_dh(&nk1k2, ct, &ctx, &sender_sk->sk, sender_pk, receiver_pk);
+    h_akem_encap_core(h_akem_k, ct, NULL, &sender_sk->essk, sender_pk, receiver_pk, &ctx, &nk1k2);
+    h_akem_peer_ctx_release(&ctx);
+
+}
+
+// Function Dec from line 27 on, with nk and the ring taken from ctx and
+// nk1k2 of line 26 computed by the caller.
+static
+int h_akem_decap_core(uint8_t *h_akem_k, const h_akem_ct *ct,
+                      const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                      const h_akem_pk *sender_pk, const h_akem_peer_ctx *ctx,
+                      const nike_s *nk1k2){
 
-    rsig_pk internal_rsig_pk;
-    nike_s nk, nkprime, nk1k2;
     uint8_t k1k2[64];
     uint8_t hmac_nk2[32];
     uint8_t hmac_out[32];
     uint8_t kprime[32];
     uint8_t m[MLEN];
-    uint8_t dec_rsig[RSIG_SIGNATURE_BYTES];
-    const uint8_t tag[4] = "auth";
-    aes128ctx ctx;
+    rsig_signature dec_rsig;
+    aes128ctx_inline aes_ctx;
     sha3_256incctx hmac_state;
 
     uint8_t *k1 = k1k2;
     uint8_t *k2 = k1 + 32;
-    uint8_t *nk1 = nk1k2.s;
-    uint8_t *nk2 = nk1 + 32;
-
-    // Lines 24 ~ 26.
-    nike_sdk(&nkprime, &receiver_sk->nsk, &sender_pk->npk);
-    hmac_sha3_256((uint8_t*)&nk.s, tag, sizeof(tag), nkprime.s);
-    nike_sdk(&nk1k2, &receiver_sk->nsk, &ct->npk);
+    const uint8_t *nk1 = nk1k2->s;
+    const uint8_t *nk2 = nk1 + 32;
 
     // Line 27.
     kem_decap(k1k2, 64, &ct->ct, &receiver_sk->ksk);
@@ -126,18 +263,16 @@ int h_akem_decap(uint8_t *h_akem_k, const h_akem_ct *ct,
 
 
     // Line 29.
-    aes128_ctr_keyexp(&ctx, kprime);
-    aes128_ctr(dec_rsig, ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
-    aes128_ctx_release(&ctx);
+    aes128_ctr_keyexp_inline(&aes_ctx, kprime);
+    aes128_ctr_inline((uint8_t*)&dec_rsig, ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &aes_ctx);
+    aes128_ctx_inline_release(&aes_ctx);
 
     // Line 30.
     memmove(m, &ct->ct, KEM_CIPHERTXT_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES, &receiver_pk->kpk, KEM_PUBLICKEY_BYTES);
 
     // Lines 31 ~ 32.
-    internal_rsig_pk.hs[0] = sender_pk->spk;
-    internal_rsig_pk.hs[1] = receiver_pk->spk;
-    if(Gandalf_verify(m, MLEN, (const rsig_signature*)dec_rsig, &internal_rsig_pk) == 0){
+    if(Gandalf_verify_prepared(m, MLEN, &dec_rsig, &ctx->ring) == 0){
         return 0;
     }
 
@@ -150,10 +285,368 @@ int h_akem_decap(uint8_t *h_akem_k, const h_akem_ct *ct,
     hmac_sha3_256_inc_finalize(hmac_out, &hmac_state, k2);
     sha3_256_inc_ctx_release(&hmac_state);
 
-    hmac_sha3_256(hmac_nk2, nk2, 32, nk.s);
+    hmac_sha3_256(hmac_nk2, nk2, 32, ctx->nk);
     hmac_sha3_256(h_akem_k, hmac_out, 32, hmac_nk2);
 
     return 1;
 
 }
 
+// Function Dec with nk and the ring taken from ctx.
+int h_akem_decap_ctx(uint8_t *h_akem_k, const h_akem_ct *ct,
+                     const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                     const h_akem_pk *sender_pk, const h_akem_peer_ctx *ctx){
+
+    nike_s nk1k2;
+
+    // Line 26.
+    nike_sdk(&nk1k2, &receiver_sk->nsk, &ct->npk);
+
+    return h_akem_decap_core(h_akem_k, ct, receiver_sk, receiver_pk, sender_pk, ctx, &nk1k2);
+
+}
+
+// Function Dec on up to H_AKEM_BATCH_LANES ciphertexts for the same
+// receiver, with the KEM secret key decoded and the signature public key
+// transformed once by the caller. Lanes failing line 32 get a zero key and
+// a cleared bit in success.
+static
+void h_akem_decap_lanes(uint8_t *h_akem_k, uint8_t *success, const h_akem_ct *ct,
+                        const h_akem_sk *receiver_sk, const kem_sk_prepared *receiver_ksk,
+                        const sign_pk_ntt *receiver_ntt, const h_akem_pk *receiver_pk,
+                        const h_akem_pk *sender_pk, size_t lanes){
+
+    h_akem_peer_ctx ctx[H_AKEM_BATCH_LANES];
+    sign_pk_ntt sender_ntt;
+    const sign_pk_ntt *members[RING_K];
+    nike_sk dh_sk[2 * H_AKEM_BATCH_LANES];
+    nike_pk dh_pk[2 * H_AKEM_BATCH_LANES];
+    nike_s nk1k2[2 * H_AKEM_BATCH_LANES];
+    uint8_t k1k2[H_AKEM_BATCH_LANES][64];
+    rsig_signature dec_rsig[H_AKEM_BATCH_LANES];
+    int valid[H_AKEM_BATCH_LANES];
+    uint8_t hmac_nk2[32];
+    uint8_t hmac_out[32];
+    uint8_t kprime[32];
+    uint8_t m[MLEN];
+    aes128ctx_inline aes_ctx;
+    sha3_256incctx hmac_state;
+
+    // Lines 24 ~ 26, with nk1k2 in nk1k2[j] and nkprime in
+    // nk1k2[lanes + j], all 2 * lanes ladders in one nike_sdk_batch call.
+    for(size_t j = 0; j < lanes; j++){
+        dh_sk[j] = receiver_sk->nsk;
+        dh_sk[lanes + j] = receiver_sk->nsk;
+        dh_pk[j] = ct[j].npk;
+        dh_pk[lanes + j] = sender_pk[j].npk;
+    }
+    nike_sdk_batch(nk1k2, dh_sk, dh_pk, 2 * lanes);
+
+    // Line 31's ring [sender_pk, receiver_pk], with only the sender's key
+    // transformed per lane.
+    members[0] = &sender_ntt;
+    members[1] = receiver_ntt;
+    for(size_t j = 0; j < lanes; j++){
+        h_akem_nk(ctx[j].nk, nk1k2 + lanes + j);
+        sign_pk_to_ntt(&sender_ntt, &sender_pk[j].spk);
+        Gandalf_prepare_pk_ntt(&ctx[j].ring, members);
+    }
+
+    // Line 27.
+    for(size_t j = 0; j < lanes; j++){
+        kem_decap_prepared(k1k2[j], 64, &ct[j].ct, receiver_ksk);
+    }
+
+    // Lines 28 ~ 29.
+    for(size_t j = 0; j < lanes; j++){
+        hmac_sha3_256(kprime, k1k2[j], 32, nk1k2[j].s);
+        aes128_ctr_keyexp_inline(&aes_ctx, kprime);
+        aes128_ctr_inline((uint8_t*)(dec_rsig + j), ct[j].enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &aes_ctx);
+        aes128_ctx_inline_release(&aes_ctx);
+    }
+
+    // Lines 30 ~ 32.
+    memmove(m + KEM_CIPHERTXT_BYTES, &receiver_pk->kpk, KEM_PUBLICKEY_BYTES);
+    for(size_t j = 0; j < lanes; j++){
+        memmove(m, &ct[j].ct, KEM_CIPHERTXT_BYTES);
+        valid[j] = Gandalf_verify_prepared(m, MLEN, dec_rsig + j, &ctx[j].ring);
+    }
+
+    // Line 33.
+    for(size_t j = 0; j < lanes; j++){
+        if(valid[j] == 0){
+            memset(h_akem_k + j * H_AKEM_CRYPTO_BYTES, 0, H_AKEM_CRYPTO_BYTES);
+            success[j] = 0;
+            continue;
+        }
+
+        hmac_sha3_256_inc_init(&hmac_state, k1k2[j] + 32);
+        sha3_256_inc_absorb(&hmac_state, (const uint8_t*)(ct + j), sizeof(h_akem_ct));
+        sha3_256_inc_absorb(&hmac_state, (const uint8_t*)(sender_pk + j), sizeof(h_akem_pk));
+        sha3_256_inc_absorb(&hmac_state, (const uint8_t*)receiver_pk, sizeof(h_akem_pk));
+        hmac_sha3_256_inc_finalize(hmac_out, &hmac_state, k1k2[j] + 32);
+        sha3_256_inc_ctx_release(&hmac_state);
+
+        hmac_sha3_256(hmac_nk2, nk1k2[j].s + 32, 32, ctx[j].nk);
+        hmac_sha3_256(h_akem_k + j * H_AKEM_CRYPTO_BYTES, hmac_out, 32, hmac_nk2);
+        success[j] = 1;
+    }
+
+    for(size_t j = 0; j < lanes; j++){
+        h_akem_peer_ctx_release(ctx + j);
+    }
+
+}
+
+size_t h_akem_decap_batch(uint8_t *h_akem_k, uint8_t *success, const h_akem_ct *ct,
+                          const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                          const h_akem_pk *sender_pk, size_t n){
+
+    kem_sk_prepared receiver_ksk;
+    sign_pk_ntt receiver_ntt;
+    uint8_t valid[H_AKEM_BATCH_LANES];
+    size_t lanes;
+    size_t count = 0;
+
+    memset(success, 0, (n + 7) / 8);
+
+    kem_prepare_sk(&receiver_ksk, &receiver_sk->ksk);
+    sign_pk_to_ntt(&receiver_ntt, &receiver_pk->spk);
+
+    for(size_t i = 0; i < n; i += lanes){
+        lanes = n - i;
+        if(lanes > H_AKEM_BATCH_LANES){
+            lanes = H_AKEM_BATCH_LANES;
+        }
+        h_akem_decap_lanes(h_akem_k + i * H_AKEM_CRYPTO_BYTES, valid, ct + i,
+                           receiver_sk, &receiver_ksk, &receiver_ntt, receiver_pk, sender_pk + i, lanes);
+        for(size_t j = 0; j < lanes; j++){
+            success[(i + j) / 8] |= valid[j] << ((i + j) % 8);
+            count += valid[j];
+        }
+    }
+
+    kem_sk_prepared_release(&receiver_ksk);
+
+    return count;
+
+}
+
+// Lines 24 ~ 26: nk1k2 and, with ctx not NULL, ctx from the static-static
+// key of lines 24 ~ 25, both ladders sharing one inversion.
+static
+void h_akem_decap_dh(nike_s *nk1k2, h_akem_peer_ctx *ctx, const h_akem_ct *ct,
+                     const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                     const h_akem_pk *sender_pk){
+
+    nike_sk dh_sk[2];
+    nike_pk dh_pk[2];
+    nike_s dh_s[2];
+
+    if(ctx == NULL){
+        nike_sdk(nk1k2, &receiver_sk->nsk, &ct->npk);
+        return;
+    }
+
+    dh_sk[0] = receiver_sk->nsk;
+    dh_sk[1] = receiver_sk->nsk;
+    dh_pk[0] = ct->npk;
+    dh_pk[1] = sender_pk->npk;
+    nike_sdk_batch(dh_s, dh_sk, dh_pk, 2);
+    *nk1k2 = dh_s[0];
+    h_akem_peer_ctx_set(ctx, dh_s + 1, sender_pk, receiver_pk);
+
+}
+
+// Function Dec.
+int h_akem_decap(uint8_t *h_akem_k, const h_akem_ct *ct,
+                 const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                 const h_akem_pk *sender_pk){
+
+    h_akem_peer_ctx ctx;
+    nike_s nk1k2;
+    int ret;
+
+    h_akem_decap_dh(&nk1k2, &ctx, ct, receiver_sk, receiver_pk, sender_pk);
+    ret = h_akem_decap_core(h_akem_k, ct, receiver_sk, receiver_pk, sender_pk, &ctx, &nk1k2);
+    h_akem_peer_ctx_release(&ctx);
+
+    return ret;
+
+}
+
+static
+void h_akem_nk_cache_entry_release(h_akem_nk_cache_entry *entry){
+    volatile uint8_t *p = (volatile uint8_t*)entry;
+    for(size_t i = 0; i < sizeof(h_akem_nk_cache_entry); i++){
+        p[i] = 0;
+    }
+}
+
+void h_akem_nk_cache_init(h_akem_nk_cache *cache){
+    memset(cache, 0, sizeof(h_akem_nk_cache));
+}
+
+void h_akem_nk_cache_release(h_akem_nk_cache *cache){
+    for(size_t i = 0; i < H_AKEM_NK_CACHE_ENTRIES; i++){
+        h_akem_nk_cache_entry_release(cache->entry + i);
+    }
+    cache->hand = 0;
+}
+
+// The entry for (own, peer), or NULL. Public keys only, so the comparison
+// need not be constant-time.
+static
+h_akem_nk_cache_entry *h_akem_nk_cache_find(h_akem_nk_cache *cache,
+                                            const nike_pk *own, const nike_pk *peer){
+
+    for(size_t i = 0; i < H_AKEM_NK_CACHE_ENTRIES; i++){
+        h_akem_nk_cache_entry *entry = cache->entry + i;
+        if(entry->used &&
+           (memcmp(&entry->own, own, sizeof(nike_pk)) == 0) &&
+           (memcmp(&entry->peer, peer, sizeof(nike_pk)) == 0)){
+            return entry;
+        }
+    }
+    return NULL;
+
+}
+
+// Stores nk for (own, peer) in a free entry or, with CLOCK, in the first
+// unpinned entry whose reference bit is clear, clearing the bits passed
+// over. The evicted key is zeroized. Returns NULL when every entry is
+// pinned.
+static
+h_akem_nk_cache_entry *h_akem_nk_cache_insert(h_akem_nk_cache *cache,
+                                              const nike_pk *own, const nike_pk *peer,
+                                              const uint8_t *nk){
+
+    h_akem_nk_cache_entry *entry = NULL;
+
+    for(size_t i = 0; i < H_AKEM_NK_CACHE_ENTRIES; i++){
+        if(!cache->entry[i].used){
+            entry = cache->entry + i;
+            break;
+        }
+    }
+
+    for(size_t i = 0; (entry == NULL) && (i < 2 * H_AKEM_NK_CACHE_ENTRIES); i++){
+        h_akem_nk_cache_entry *candidate = cache->entry + cache->hand;
+        cache->hand = (cache->hand + 1) % H_AKEM_NK_CACHE_ENTRIES;
+        if(candidate->pinned){
+            continue;
+        }
+        if(candidate->referenced){
+            candidate->referenced = 0;
+            continue;
+        }
+        h_akem_nk_cache_entry_release(candidate);
+        entry = candidate;
+    }
+
+    if(entry == NULL){
+        return NULL;
+    }
+
+    entry->own = *own;
+    entry->peer = *peer;
+    memcpy(entry->nk, nk, sizeof(entry->nk));
+    entry->used = 1;
+    entry->referenced = 1;
+    entry->pinned = 0;
+    return entry;
+
+}
+
+int h_akem_nk_cache_pin(h_akem_nk_cache *cache,
+                        const h_akem_sk *own_sk, const h_akem_pk *own_pk,
+                        const h_akem_pk *peer_pk){
+
+    h_akem_nk_cache_entry *entry;
+    nike_s nkprime;
+    uint8_t nk[32];
+
+    entry = h_akem_nk_cache_find(cache, &own_pk->npk, &peer_pk->npk);
+    if(entry == NULL){
+        nike_sdk(&nkprime, &own_sk->nsk, &peer_pk->npk);
+        h_akem_nk(nk, &nkprime);
+        entry = h_akem_nk_cache_insert(cache, &own_pk->npk, &peer_pk->npk, nk);
+    }
+    if(entry == NULL){
+        return 0;
+    }
+    entry->pinned = 1;
+    return 1;
+
+}
+
+void h_akem_nk_cache_unpin(h_akem_nk_cache *cache,
+                           const h_akem_pk *own_pk, const h_akem_pk *peer_pk){
+
+    h_akem_nk_cache_entry *entry = h_akem_nk_cache_find(cache, &own_pk->npk, &peer_pk->npk);
+
+    if(entry != NULL){
+        entry->pinned = 0;
+    }
+
+}
+
+// Function Enc with nk looked up in cache, or computed and inserted on a
+// miss.
+void h_akem_encap_cached(uint8_t *h_akem_k, h_akem_ct *ct,
+                         const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                         const h_akem_pk *receiver_pk, h_akem_nk_cache *cache){
+
+    h_akem_peer_ctx ctx;
+    nike_s nk1k2;
+    h_akem_nk_cache_entry *entry;
+
+    entry = h_akem_nk_cache_find(cache, &sender_pk->npk, &receiver_pk->npk);
+    if(entry != NULL){
+        entry->referenced = 1;
+        memcpy(ctx.nk, entry->nk, sizeof(ctx.nk));
+        h_akem_peer_ctx_set_ring(&ctx, sender_pk, receiver_pk);
+        h_akem_encap_dh(&nk1k2, ct, NULL, NULL, sender_pk, receiver_pk);
+    }else{
+        h_akem_encap_dh(&nk1k2, ct, &ctx, sender_sk, sender_pk, receiver_pk);
+        h_akem_nk_cache_insert(cache, &sender_pk->npk, &receiver_pk->npk, ctx.nk);
+    }
+
+    h_akem_encap_core(h_akem_k, ct, &sender_sk->ssk, NULL, sender_pk, receiver_pk, &ctx, &nk1k2);
+    h_akem_peer_ctx_release(&ctx);
+
+}
+
+// Function Dec with nk looked up in cache, or computed on a miss and
+// inserted once the ciphertext is accepted.
+int h_akem_decap_cached(uint8_t *h_akem_k, const h_akem_ct *ct,
+                        const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                        const h_akem_pk *sender_pk, h_akem_nk_cache *cache){
+
+    h_akem_peer_ctx ctx;
+    nike_s nk1k2;
+    h_akem_nk_cache_entry *entry;
+    int ret;
+
+    entry = h_akem_nk_cache_find(cache, &receiver_pk->npk, &sender_pk->npk);
+    if(entry != NULL){
+        entry->referenced = 1;
+        memcpy(ctx.nk, entry->nk, sizeof(ctx.nk));
+        h_akem_peer_ctx_set_ring(&ctx, sender_pk, receiver_pk);
+        h_akem_decap_dh(&nk1k2, NULL, ct, receiver_sk, receiver_pk, sender_pk);
+    }else{
+        h_akem_decap_dh(&nk1k2, &ctx, ct, receiver_sk, receiver_pk, sender_pk);
+    }
+
+    ret = h_akem_decap_core(h_akem_k, ct, receiver_sk, receiver_pk, sender_pk, &ctx, &nk1k2);
+
+    // Only authenticated senders are inserted, so that forged ciphertexts
+    // claiming arbitrary sender_pk cannot evict legitimate peers.
+    if((entry == NULL) && (ret == 1)){
+        h_akem_nk_cache_insert(cache, &receiver_pk->npk, &sender_pk->npk, ctx.nk);
+    }
+    h_akem_peer_ctx_release(&ctx);
+
+    return ret;
+
+}
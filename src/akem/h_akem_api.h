@@ -23,21 +23,124 @@ typedef struct {
     uint8_t enc_rsig[RSIG_SIGNATURE_BYTES];
 } h_akem_ct;
 
+// State shared by every encapsulation between the same sender and receiver:
+// the static-static NIKE key nk and the ring public key [sender, receiver]
+// with both members decoded and in the NTT domain.
+typedef struct {
+    uint8_t nk[32];
+    rsig_pk_prepared ring;
+} h_akem_peer_ctx;
+
+// Number of entries of h_akem_nk_cache.
+#ifndef H_AKEM_NK_CACHE_ENTRIES
+#define H_AKEM_NK_CACHE_ENTRIES 16
+#endif
+
+// The static-static key nk between the NIKE public keys own and peer. nk
+// is symmetric, so the same entry serves both directions.
+typedef struct {
+    nike_pk own;
+    nike_pk peer;
+    uint8_t nk[32];
+    uint8_t used;
+    uint8_t referenced;
+    uint8_t pinned;
+} h_akem_nk_cache_entry;
+
+// Bounded cache of nk with CLOCK eviction: hits set the reference bit of an
+// entry, and a miss with no free entry evicts the first unpinned entry
+// found by hand whose bit is clear. Evicted entries are zeroized.
+typedef struct {
+    h_akem_nk_cache_entry entry[H_AKEM_NK_CACHE_ENTRIES];
+    size_t hand;
+} h_akem_nk_cache;
+
+// Sender secret key with the ring-signature key expanded once, so that
+// repeated encapsulations skip the per-signature basis computations.
+typedef struct {
+    h_akem_sk sk;
+    sign_expanded_sk essk;
+} h_akem_expanded_sk;
+
 #define H_AKEM_SECRETKEY_BYTES sizeof(h_akem_sk)
 #define H_AKEM_PUBLICKEY_BYTES sizeof(h_akem_pk)
 #define H_AKEM_CIPHERTXT_BYTES sizeof(h_akem_ct)
 #define H_AKEM_CRYPTO_BYTES ((size_t)32)
 // Message length for the ring signature.
 #define MLEN (KEM_CIPHERTXT_BYTES + KEM_PUBLICKEY_BYTES)
+// Number of ciphertexts h_akem_decap_batch processes side by side.
+#define H_AKEM_BATCH_LANES 4
 
 void h_akem_keygen(h_akem_sk *sk, h_akem_pk *pk);
 
 void h_akem_encap(uint8_t *h_akem_k, h_akem_ct *ct,
                   const h_akem_sk *sender_sk, const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk);
 
+void h_akem_expand_sk(h_akem_expanded_sk *expanded_sk, const h_akem_sk *sk);
+
+void h_akem_expanded_sk_release(h_akem_expanded_sk *expanded_sk);
+
+void h_akem_encap_expanded_sk(uint8_t *h_akem_k, h_akem_ct *ct,
+                              const h_akem_expanded_sk *sender_sk, const h_akem_pk *sender_pk,
+                              const h_akem_pk *receiver_pk);
+
 int h_akem_decap(uint8_t *h_akem_k, const h_akem_ct *ct,
                  const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
                  const h_akem_pk *sender_pk);
 
+void h_akem_peer_ctx_init_sender(h_akem_peer_ctx *ctx,
+                                 const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                                 const h_akem_pk *receiver_pk);
+
+void h_akem_peer_ctx_init_receiver(h_akem_peer_ctx *ctx,
+                                   const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                                   const h_akem_pk *sender_pk);
+
+void h_akem_peer_ctx_release(h_akem_peer_ctx *ctx);
+
+void h_akem_encap_ctx(uint8_t *h_akem_k, h_akem_ct *ct,
+                      const h_akem_sk *sender_sk, const h_akem_pk *sender_pk, const h_akem_pk *receiver_pk,
+                      const h_akem_peer_ctx *ctx);
+
+int h_akem_decap_ctx(uint8_t *h_akem_k, const h_akem_ct *ct,
+                     const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                     const h_akem_pk *sender_pk, const h_akem_peer_ctx *ctx);
+
+void h_akem_nk_cache_init(h_akem_nk_cache *cache);
+
+// Zeroizes every entry.
+void h_akem_nk_cache_release(h_akem_nk_cache *cache);
+
+// Computes nk for (own_pk, peer_pk) if absent and keeps it from eviction
+// until h_akem_nk_cache_unpin. Returns 0 when every entry is already pinned.
+int h_akem_nk_cache_pin(h_akem_nk_cache *cache,
+                        const h_akem_sk *own_sk, const h_akem_pk *own_pk,
+                        const h_akem_pk *peer_pk);
+
+void h_akem_nk_cache_unpin(h_akem_nk_cache *cache,
+                           const h_akem_pk *own_pk, const h_akem_pk *peer_pk);
+
+// h_akem_encap and h_akem_decap taking nk from cache, and inserting it on a
+// miss (for h_akem_decap_cached, only when the ciphertext is accepted).
+// Entries are keyed by the caller's own public key and the peer's: sender_pk
+// and receiver_pk for h_akem_encap_cached, receiver_pk and sender_pk for
+// h_akem_decap_cached. sender_pk must belong to sender_sk, and receiver_pk
+// to receiver_sk.
+void h_akem_encap_cached(uint8_t *h_akem_k, h_akem_ct *ct,
+                         const h_akem_sk *sender_sk, const h_akem_pk *sender_pk,
+                         const h_akem_pk *receiver_pk, h_akem_nk_cache *cache);
+
+int h_akem_decap_cached(uint8_t *h_akem_k, const h_akem_ct *ct,
+                        const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                        const h_akem_pk *sender_pk, h_akem_nk_cache *cache);
+
+// Decapsulates n ciphertexts addressed to one receiver, ct[i] coming from sender_pk[i].
+// h_akem_k holds n * H_AKEM_CRYPTO_BYTES bytes, success holds (n + 7) / 8 bytes.
+// Bit i % 8 of success[i / 8] is set iff ct[i] is accepted; the key of a
+// rejected ciphertext is zeroed. Returns the number of accepted ciphertexts.
+size_t h_akem_decap_batch(uint8_t *h_akem_k, uint8_t *success, const h_akem_ct *ct,
+                          const h_akem_sk *receiver_sk, const h_akem_pk *receiver_pk,
+                          const h_akem_pk *sender_pk, size_t n);
+
 #endif
 
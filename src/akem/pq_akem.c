@@ -5,6 +5,12 @@
 
 #include <string.h>
 
+// The AKEM rings are [sender_pk, receiver_pk]; larger RING_K only applies to
+// the ring signature built on its own (make -C <rsig dir> test RING_K=k).
+#if RING_K != 2
+#error "The AKEMs need RING_K == 2"
+#endif
+
 static const uint8_t aes_iv[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
 void pq_akem_keygen(pq_akem_sk *sk, pq_akem_pk *pk){
@@ -12,22 +18,35 @@ void pq_akem_keygen(pq_akem_sk *sk, pq_akem_pk *pk){
     sign_keygen(&sk->ssk, &pk->spk);
 }
 
-void pq_akem_encap(uint8_t *pq_akem_k, pq_akem_ct *ct,
-                               const pq_akem_sk *sender_sk, const pq_akem_pk *sender_pk,
-                               const pq_akem_pk *receiver_pk){
+void pq_akem_expand_sk(pq_akem_expanded_sk *expanded_sk, const pq_akem_sk *sk){
+    expanded_sk->sk = *sk;
+    expand_sign_sk(&expanded_sk->essk, &sk->ssk);
+}
+
+void pq_akem_expanded_sk_release(pq_akem_expanded_sk *expanded_sk){
+    volatile uint8_t *p = (volatile uint8_t*)expanded_sk;
+    for(size_t i = 0; i < sizeof(pq_akem_expanded_sk); i++){
+        p[i] = 0;
+    }
+}
+
+// Signs with sender_essk when it is not NULL, with sender_ssk otherwise.
+static
+void pq_akem_encap_core(uint8_t *pq_akem_k, pq_akem_ct *ct,
+                        const sign_sk *sender_ssk, const sign_expanded_sk *sender_essk,
+                        const pq_akem_pk *sender_pk, const pq_akem_pk *receiver_pk){
 
-    kem_ct internal_kem_ct;
     rsig_pk internal_rsig_pk;
-    rsig_signature internal_signature;
     uint8_t kk[48];
     uint8_t m[MLEN];
-    uint8_t enc_rsig[RSIG_SIGNATURE_BYTES];
-    aes128ctx ctx;
+    aes128ctx_inline ctx;
     sha3_256incctx hash_state;
 
-    kem_encap(kk, 48, &internal_kem_ct, &receiver_pk->kpk);
+    // The KEM ciphertext and the signature are produced in place in ct;
+    // the signature is then encrypted over itself.
+    kem_encap(kk, 48, &ct->ct, &receiver_pk->kpk);
 
-    memmove(m, &internal_kem_ct, KEM_CIPHERTXT_BYTES);
+    memmove(m, &ct->ct, KEM_CIPHERTXT_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES, &sender_pk->kpk, KEM_PUBLICKEY_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES + KEM_PUBLICKEY_BYTES, &receiver_pk->kpk, KEM_PUBLICKEY_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES + 2 * KEM_PUBLICKEY_BYTES, &receiver_pk->spk, SIGN_PUBLICKEY_BYTES);
@@ -35,18 +54,19 @@ void pq_akem_encap(uint8_t *pq_akem_k, pq_akem_ct *ct,
     internal_rsig_pk.hs[0] = sender_pk->spk;
     internal_rsig_pk.hs[1] = receiver_pk->spk;
 
-    Gandalf_sign(&internal_signature, m, MLEN, &internal_rsig_pk, &sender_sk->ssk, 0);
-
-    aes128_ctr_keyexp(&ctx, kk);
-    aes128_ctr(enc_rsig, (void*)&internal_signature, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
-    aes128_ctx_release(&ctx);
+    if(sender_essk != NULL){
+        Gandalf_sign_expanded_sk((rsig_signature*)ct->enc_rsig, m, MLEN, &internal_rsig_pk, sender_essk, 0);
+    }else{
+        Gandalf_sign((rsig_signature*)ct->enc_rsig, m, MLEN, &internal_rsig_pk, sender_ssk, 0);
+    }
 
-    ct->ct = internal_kem_ct;
-    memmove(ct->enc_rsig, enc_rsig, RSIG_SIGNATURE_BYTES);
+    aes128_ctr_keyexp_inline(&ctx, kk);
+    aes128_ctr_inplace_inline(ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
+    aes128_ctx_inline_release(&ctx);
 
     sha3_256_inc_init(&hash_state);
     sha3_256_inc_absorb(&hash_state, kk + 16, 32);
-    sha3_256_inc_absorb(&hash_state, enc_rsig, RSIG_SIGNATURE_BYTES);
+    sha3_256_inc_absorb(&hash_state, ct->enc_rsig, RSIG_SIGNATURE_BYTES);
     sha3_256_inc_absorb(&hash_state, (const uint8_t *)&sender_pk->spk, SIGN_PUBLICKEY_BYTES);
     sha3_256_inc_absorb(&hash_state, m, MLEN);
     sha3_256_inc_finalize(pq_akem_k, &hash_state);
@@ -54,6 +74,22 @@ void pq_akem_encap(uint8_t *pq_akem_k, pq_akem_ct *ct,
 
 }
 
+void pq_akem_encap(uint8_t *pq_akem_k, pq_akem_ct *ct,
+                   const pq_akem_sk *sender_sk, const pq_akem_pk *sender_pk,
+                   const pq_akem_pk *receiver_pk){
+
+    pq_akem_encap_core(pq_akem_k, ct, &sender_sk->ssk, NULL, sender_pk, receiver_pk);
+
+}
+
+void pq_akem_encap_expanded_sk(uint8_t *pq_akem_k, pq_akem_ct *ct,
+                               const pq_akem_expanded_sk *sender_sk, const pq_akem_pk *sender_pk,
+                               const pq_akem_pk *receiver_pk){
+
+    pq_akem_encap_core(pq_akem_k, ct, NULL, &sender_sk->essk, sender_pk, receiver_pk);
+
+}
+
 int pq_akem_decap(uint8_t *pq_akem_k, const pq_akem_ct *ct,
                   const pq_akem_sk *receiver_sk, const pq_akem_pk *receiver_pk,
                   const pq_akem_pk *sender_pk){
@@ -61,15 +97,15 @@ int pq_akem_decap(uint8_t *pq_akem_k, const pq_akem_ct *ct,
     rsig_pk internal_rsig_pk;
     uint8_t kk[48];
     uint8_t m[MLEN];
-    uint8_t dec_rsig[RSIG_SIGNATURE_BYTES];
-    aes128ctx ctx;
+    rsig_signature dec_rsig;
+    aes128ctx_inline ctx;
     sha3_256incctx hash_state;
 
     kem_decap(kk, 48, &ct->ct, &receiver_sk->ksk);
 
-    aes128_ctr_keyexp(&ctx, kk);
-    aes128_ctr(dec_rsig, (void*)&ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
-    aes128_ctx_release(&ctx);
+    aes128_ctr_keyexp_inline(&ctx, kk);
+    aes128_ctr_inline((uint8_t*)&dec_rsig, ct->enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
+    aes128_ctx_inline_release(&ctx);
 
     memmove(m, &ct->ct, KEM_CIPHERTXT_BYTES);
     memmove(m + KEM_CIPHERTXT_BYTES, &sender_pk->kpk, KEM_PUBLICKEY_BYTES);
@@ -79,7 +115,7 @@ int pq_akem_decap(uint8_t *pq_akem_k, const pq_akem_ct *ct,
     internal_rsig_pk.hs[0] = sender_pk->spk;
     internal_rsig_pk.hs[1] = receiver_pk->spk;
 
-    if(Gandalf_verify(m, MLEN, (const rsig_signature*)dec_rsig, &internal_rsig_pk) == 0){
+    if(Gandalf_verify(m, MLEN, &dec_rsig, &internal_rsig_pk) == 0){
         return 0;
     }
 
@@ -95,5 +131,100 @@ int pq_akem_decap(uint8_t *pq_akem_k, const pq_akem_ct *ct,
 
 }
 
+// pq_akem_decap on up to PQ_AKEM_BATCH_LANES ciphertexts for the same
+// receiver, with the KEM secret key decoded and the signature public key
+// transformed once by the caller.
+static
+void pq_akem_decap_lanes(uint8_t *pq_akem_k, uint8_t *success, const pq_akem_ct *ct,
+                         const kem_sk_prepared *receiver_ksk, const sign_pk_ntt *receiver_ntt,
+                         const pq_akem_pk *receiver_pk, const pq_akem_pk *sender_pk, size_t lanes){
+
+    rsig_pk_prepared internal_rsig_pk;
+    sign_pk_ntt sender_ntt;
+    const sign_pk_ntt *members[RING_K];
+    uint8_t kk[PQ_AKEM_BATCH_LANES][48];
+    uint8_t m[PQ_AKEM_BATCH_LANES][MLEN];
+    rsig_signature dec_rsig[PQ_AKEM_BATCH_LANES];
+    int valid[PQ_AKEM_BATCH_LANES];
+    aes128ctx_inline ctx;
+    sha3_256incctx hash_state;
+
+    for(size_t j = 0; j < lanes; j++){
+        kem_decap_prepared(kk[j], 48, &ct[j].ct, receiver_ksk);
+    }
+
+    for(size_t j = 0; j < lanes; j++){
+        aes128_ctr_keyexp_inline(&ctx, kk[j]);
+        aes128_ctr_inline((uint8_t*)(dec_rsig + j), ct[j].enc_rsig, RSIG_SIGNATURE_BYTES, aes_iv, &ctx);
+        aes128_ctx_inline_release(&ctx);
+    }
 
+    for(size_t j = 0; j < lanes; j++){
+        memmove(m[j], &ct[j].ct, KEM_CIPHERTXT_BYTES);
+        memmove(m[j] + KEM_CIPHERTXT_BYTES, &sender_pk[j].kpk, KEM_PUBLICKEY_BYTES);
+        memmove(m[j] + KEM_CIPHERTXT_BYTES + KEM_PUBLICKEY_BYTES, &receiver_pk->kpk, KEM_PUBLICKEY_BYTES);
+        memmove(m[j] + KEM_CIPHERTXT_BYTES + 2 * KEM_PUBLICKEY_BYTES, &receiver_pk->spk, SIGN_PUBLICKEY_BYTES);
+    }
+
+    // The receiver's key is shared by every lane and transformed once by
+    // the caller.
+    members[0] = &sender_ntt;
+    members[1] = receiver_ntt;
+    for(size_t j = 0; j < lanes; j++){
+        sign_pk_to_ntt(&sender_ntt, &sender_pk[j].spk);
+        Gandalf_prepare_pk_ntt(&internal_rsig_pk, members);
+        valid[j] = Gandalf_verify_prepared(m[j], MLEN, dec_rsig + j, &internal_rsig_pk);
+    }
 
+    for(size_t j = 0; j < lanes; j++){
+        if(valid[j] == 0){
+            memset(pq_akem_k + j * PQ_AKEM_CRYPTO_BYTES, 0, PQ_AKEM_CRYPTO_BYTES);
+            success[j] = 0;
+            continue;
+        }
+
+        sha3_256_inc_init(&hash_state);
+        sha3_256_inc_absorb(&hash_state, kk[j] + 16, 32);
+        sha3_256_inc_absorb(&hash_state, ct[j].enc_rsig, RSIG_SIGNATURE_BYTES);
+        sha3_256_inc_absorb(&hash_state, (const uint8_t *)&sender_pk[j].spk, SIGN_PUBLICKEY_BYTES);
+        sha3_256_inc_absorb(&hash_state, m[j], MLEN);
+        sha3_256_inc_finalize(pq_akem_k + j * PQ_AKEM_CRYPTO_BYTES, &hash_state);
+        sha3_256_inc_ctx_release(&hash_state);
+        success[j] = 1;
+    }
+
+}
+
+size_t pq_akem_decap_batch(uint8_t *pq_akem_k, uint8_t *success, const pq_akem_ct *ct,
+                           const pq_akem_sk *receiver_sk, const pq_akem_pk *receiver_pk,
+                           const pq_akem_pk *sender_pk, size_t n){
+
+    kem_sk_prepared receiver_ksk;
+    sign_pk_ntt receiver_ntt;
+    uint8_t valid[PQ_AKEM_BATCH_LANES];
+    size_t lanes;
+    size_t count = 0;
+
+    memset(success, 0, (n + 7) / 8);
+
+    kem_prepare_sk(&receiver_ksk, &receiver_sk->ksk);
+    sign_pk_to_ntt(&receiver_ntt, &receiver_pk->spk);
+
+    for(size_t i = 0; i < n; i += lanes){
+        lanes = n - i;
+        if(lanes > PQ_AKEM_BATCH_LANES){
+            lanes = PQ_AKEM_BATCH_LANES;
+        }
+        pq_akem_decap_lanes(pq_akem_k + i * PQ_AKEM_CRYPTO_BYTES, valid, ct + i,
+                            &receiver_ksk, &receiver_ntt, receiver_pk, sender_pk + i, lanes);
+        for(size_t j = 0; j < lanes; j++){
+            success[(i + j) / 8] |= valid[j] << ((i + j) % 8);
+            count += valid[j];
+        }
+    }
+
+    kem_sk_prepared_release(&receiver_ksk);
+
+    return count;
+
+}
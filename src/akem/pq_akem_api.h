@@ -19,19 +19,41 @@ typedef struct {
     uint8_t enc_rsig[RSIG_SIGNATURE_BYTES];
 } pq_akem_ct;
 
+// Sender secret key with the ring-signature key expanded once, so that
+// repeated encapsulations skip the per-signature basis computations.
+typedef struct {
+    pq_akem_sk sk;
+    sign_expanded_sk essk;
+} pq_akem_expanded_sk;
+
 #define PQ_AKEM_SECRETKEY_BYTES sizeof(pq_akem_sk)
 #define PQ_AKEM_PUBLICKEY_BYTES sizeof(pq_akem_pk)
 #define PQ_AKEM_CIPHERTXT_BYTES sizeof(pq_akem_ct)
 #define PQ_AKEM_CRYPTO_BYTES ((size_t)32)
 // Message length for the ring signature.
 #define MLEN (KEM_CIPHERTXT_BYTES + 2 * KEM_PUBLICKEY_BYTES + SIGN_PUBLICKEY_BYTES)
+// Number of ciphertexts pq_akem_decap_batch processes side by side.
+#define PQ_AKEM_BATCH_LANES 4
 
 void pq_akem_keygen(pq_akem_sk *sk, pq_akem_pk *pk);
 void pq_akem_encap(uint8_t *pq_akem_k, pq_akem_ct *ct,
                 const pq_akem_sk *sender_sk, const pq_akem_pk *sender_pk, const pq_akem_pk *receiver_pk);
 
+void pq_akem_expand_sk(pq_akem_expanded_sk *expanded_sk, const pq_akem_sk *sk);
+void pq_akem_expanded_sk_release(pq_akem_expanded_sk *expanded_sk);
+void pq_akem_encap_expanded_sk(uint8_t *pq_akem_k, pq_akem_ct *ct,
+                const pq_akem_expanded_sk *sender_sk, const pq_akem_pk *sender_pk, const pq_akem_pk *receiver_pk);
+
 int pq_akem_decap(uint8_t *pq_akem_k, const pq_akem_ct *ct,
                const pq_akem_sk *receiver_sk, const pq_akem_pk *receiver_pk, const pq_akem_pk *sender_pk);
 
+// Decapsulates n ciphertexts addressed to one receiver, ct[i] coming from sender_pk[i].
+// pq_akem_k holds n * PQ_AKEM_CRYPTO_BYTES bytes, success holds (n + 7) / 8 bytes.
+// Bit i % 8 of success[i / 8] is set iff ct[i] is accepted; the key of a
+// rejected ciphertext is zeroed. Returns the number of accepted ciphertexts.
+size_t pq_akem_decap_batch(uint8_t *pq_akem_k, uint8_t *success, const pq_akem_ct *ct,
+                           const pq_akem_sk *receiver_sk, const pq_akem_pk *receiver_pk,
+                           const pq_akem_pk *sender_pk, size_t n);
+
 #endif
 
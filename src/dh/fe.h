@@ -3,42 +3,59 @@
 
 #include <stdint.h>
 
-typedef int32_t fe[10];
+#include "fe25.h"
+#include "fe51.h"
 
 /*
 fe means field element.
 Here the field is \Z/(2^255-19).
-An element t, entries t[0]...t[9], represents the integer
-t[0]+2^26 t[1]+2^51 t[2]+2^77 t[3]+2^102 t[4]+...+2^230 t[9].
-Bounds on each t[i] vary depending on context.
+It is fe51 (five 51-bit limbs with 64x64->128 products) on 64-bit targets
+and fe25 (ref10, ten limbs of 25.5 bits) elsewhere. Define FE_RADIX51 to
+0 or 1 in order to override the choice.
 */
 
-// #define fe_frombytes CRYPTO_NAMESPACE(fe_frombytes)
-// #define fe_tobytes CRYPTO_NAMESPACE(fe_tobytes)
-// #define fe_copy CRYPTO_NAMESPACE(fe_copy)
-// #define fe_0 CRYPTO_NAMESPACE(fe_0)
-// #define fe_1 CRYPTO_NAMESPACE(fe_1)
-// #define fe_cswap CRYPTO_NAMESPACE(fe_cswap)
-// #define fe_add CRYPTO_NAMESPACE(fe_add)
-// #define fe_sub CRYPTO_NAMESPACE(fe_sub)
-// #define fe_mul CRYPTO_NAMESPACE(fe_mul)
-// #define fe_sq CRYPTO_NAMESPACE(fe_sq)
-// #define fe_mul121666 CRYPTO_NAMESPACE(fe_mul121666)
-// #define fe_invert CRYPTO_NAMESPACE(fe_invert)
-
-extern void fe_frombytes(fe,const unsigned char *);
-extern void fe_tobytes(unsigned char *,fe);
-
-extern void fe_copy(fe,fe);
-extern void fe_0(fe);
-extern void fe_1(fe);
-extern void fe_cswap(fe,fe,unsigned int);
-
-extern void fe_add(fe,fe,fe);
-extern void fe_sub(fe,fe,fe);
-extern void fe_mul(fe,fe,fe);
-extern void fe_sq(fe,fe);
-extern void fe_mul121666(fe,fe);
-extern void fe_invert(fe,fe);
+#ifndef FE_RADIX51
+#if FE51_AVAILABLE && UINTPTR_MAX > 0xFFFFFFFFu
+#define FE_RADIX51 1
+#else
+#define FE_RADIX51 0
+#endif
+#endif
+
+#if FE_RADIX51
+
+typedef fe51 fe;
+
+#define fe_frombytes fe51_frombytes
+#define fe_tobytes fe51_tobytes
+#define fe_copy fe51_copy
+#define fe_0 fe51_0
+#define fe_1 fe51_1
+#define fe_cswap fe51_cswap
+#define fe_add fe51_add
+#define fe_sub fe51_sub
+#define fe_mul fe51_mul
+#define fe_sq fe51_sq
+#define fe_mul121666 fe51_mul121666
+#define fe_invert fe51_invert
+
+#else
+
+typedef fe25 fe;
+
+#define fe_frombytes fe25_frombytes
+#define fe_tobytes fe25_tobytes
+#define fe_copy fe25_copy
+#define fe_0 fe25_0
+#define fe_1 fe25_1
+#define fe_cswap fe25_cswap
+#define fe_add fe25_add
+#define fe_sub fe25_sub
+#define fe_mul fe25_mul
+#define fe_sq fe25_sq
+#define fe_mul121666 fe25_mul121666
+#define fe_invert fe25_invert
+
+#endif
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef FE25_H
+#define FE25_H
+
+#include <stdint.h>
+
+typedef int32_t fe25[10];
+
+/*
+fe25 is the ref10 field element.
+Here the field is \Z/(2^255-19).
+An element t, entries t[0]...t[9], represents the integer
+t[0]+2^26 t[1]+2^51 t[2]+2^77 t[3]+2^102 t[4]+...+2^230 t[9].
+Bounds on each t[i] vary depending on context.
+*/
+
+extern void fe25_frombytes(fe25,const unsigned char *);
+extern void fe25_tobytes(unsigned char *,fe25);
+
+extern void fe25_copy(fe25,fe25);
+extern void fe25_0(fe25);
+extern void fe25_1(fe25);
+extern void fe25_cswap(fe25,fe25,unsigned int);
+
+extern void fe25_add(fe25,fe25,fe25);
+extern void fe25_sub(fe25,fe25,fe25);
+extern void fe25_mul(fe25,fe25,fe25);
+extern void fe25_sq(fe25,fe25);
+extern void fe25_mul121666(fe25,fe25);
+extern void fe25_invert(fe25,fe25);
+
+#endif
@@ -0,0 +1,263 @@
+#include "fe51.h"
+
+#if FE51_AVAILABLE
+
+typedef unsigned __int128 uint128_t;
+
+#define MASK51 (((uint64_t)1 << 51) - 1)
+
+static uint64_t load64(const unsigned char *in)
+{
+  uint64_t r = 0;
+  int i;
+
+  for (i = 7;i >= 0;--i) r = (r << 8) | in[i];
+  return r;
+}
+
+static void store64(unsigned char *out,uint64_t x)
+{
+  int i;
+
+  for (i = 0;i < 8;++i) {
+    out[i] = (unsigned char) x;
+    x >>= 8;
+  }
+}
+
+/*
+Ignores top bit of s.
+*/
+
+void fe51_frombytes(fe51 h,const unsigned char *s)
+{
+  h[0] = load64(s) & MASK51;
+  h[1] = (load64(s + 6) >> 3) & MASK51;
+  h[2] = (load64(s + 12) >> 6) & MASK51;
+  h[3] = (load64(s + 19) >> 1) & MASK51;
+  h[4] = (load64(s + 24) >> 12) & MASK51;
+}
+
+static void fe51_carry(uint64_t *t)
+{
+  t[1] += t[0] >> 51; t[0] &= MASK51;
+  t[2] += t[1] >> 51; t[1] &= MASK51;
+  t[3] += t[2] >> 51; t[2] &= MASK51;
+  t[4] += t[3] >> 51; t[3] &= MASK51;
+  t[0] += 19 * (t[4] >> 51); t[4] &= MASK51;
+}
+
+/*
+Writes the unique representative in [0, p) of h, as in curve25519-donna.
+*/
+
+void fe51_tobytes(unsigned char *s,fe51 h)
+{
+  uint64_t t[5];
+
+  t[0] = h[0];
+  t[1] = h[1];
+  t[2] = h[2];
+  t[3] = h[3];
+  t[4] = h[4];
+
+  fe51_carry(t);
+  fe51_carry(t);
+
+  /* t is in [0, 2^255 - 1]. Adding 19 and then 2^255 - 19 maps [p, 2^255)
+     past 2^256 and keeps [0, p) below it, so dropping bit 255 reduces. */
+  t[0] += 19;
+  fe51_carry(t);
+
+  t[0] += ((uint64_t)1 << 51) - 19;
+  t[1] += ((uint64_t)1 << 51) - 1;
+  t[2] += ((uint64_t)1 << 51) - 1;
+  t[3] += ((uint64_t)1 << 51) - 1;
+  t[4] += ((uint64_t)1 << 51) - 1;
+
+  t[1] += t[0] >> 51; t[0] &= MASK51;
+  t[2] += t[1] >> 51; t[1] &= MASK51;
+  t[3] += t[2] >> 51; t[2] &= MASK51;
+  t[4] += t[3] >> 51; t[3] &= MASK51;
+  t[4] &= MASK51;
+
+  store64(s, t[0] | (t[1] << 51));
+  store64(s + 8, (t[1] >> 13) | (t[2] << 38));
+  store64(s + 16, (t[2] >> 26) | (t[3] << 25));
+  store64(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+void fe51_copy(fe51 h,fe51 f)
+{
+  h[0] = f[0];
+  h[1] = f[1];
+  h[2] = f[2];
+  h[3] = f[3];
+  h[4] = f[4];
+}
+
+void fe51_0(fe51 h)
+{
+  h[0] = 0;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+void fe51_1(fe51 h)
+{
+  h[0] = 1;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+/*
+Replace (f,g) with (g,f) if b == 1;
+replace (f,g) with (f,g) if b == 0.
+
+Preconditions: b in {0,1}.
+*/
+
+void fe51_cswap(fe51 f,fe51 g,unsigned int b)
+{
+  uint64_t mask = -(uint64_t) b;
+  uint64_t x;
+  int i;
+
+  for (i = 0;i < 5;++i) {
+    x = (f[i] ^ g[i]) & mask;
+    f[i] ^= x;
+    g[i] ^= x;
+  }
+}
+
+void fe51_add(fe51 h,fe51 f,fe51 g)
+{
+  h[0] = f[0] + g[0];
+  h[1] = f[1] + g[1];
+  h[2] = f[2] + g[2];
+  h[3] = f[3] + g[3];
+  h[4] = f[4] + g[4];
+}
+
+/*
+h = f - g + 4p, so that every entry stays non-negative.
+*/
+
+void fe51_sub(fe51 h,fe51 f,fe51 g)
+{
+  h[0] = (f[0] + 0x1FFFFFFFFFFFB4) - g[0];
+  h[1] = (f[1] + 0x1FFFFFFFFFFFFC) - g[1];
+  h[2] = (f[2] + 0x1FFFFFFFFFFFFC) - g[2];
+  h[3] = (f[3] + 0x1FFFFFFFFFFFFC) - g[3];
+  h[4] = (f[4] + 0x1FFFFFFFFFFFFC) - g[4];
+}
+
+/*
+Carries the 128-bit column sums r into h. With entries of the inputs below
+2^54 the top carry is below 2^60, so 19 times it fits in 64 bits.
+*/
+
+static void fe51_reduce(fe51 h,uint128_t r0,uint128_t r1,uint128_t r2,uint128_t r3,uint128_t r4)
+{
+  uint64_t h0, h1, h2, h3, h4;
+  uint64_t c;
+
+  h0 = (uint64_t) r0 & MASK51; r1 += (uint64_t) (r0 >> 51);
+  h1 = (uint64_t) r1 & MASK51; r2 += (uint64_t) (r1 >> 51);
+  h2 = (uint64_t) r2 & MASK51; r3 += (uint64_t) (r2 >> 51);
+  h3 = (uint64_t) r3 & MASK51; r4 += (uint64_t) (r3 >> 51);
+  h4 = (uint64_t) r4 & MASK51; c = (uint64_t) (r4 >> 51);
+  h0 += c * 19;
+  h1 += h0 >> 51; h0 &= MASK51;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+/*
+h = f * g
+Can overlap h with f or g.
+*/
+
+void fe51_mul(fe51 h,fe51 f,fe51 g)
+{
+  uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  uint64_t g1_19 = 19 * g1;
+  uint64_t g2_19 = 19 * g2;
+  uint64_t g3_19 = 19 * g3;
+  uint64_t g4_19 = 19 * g4;
+  uint128_t r0, r1, r2, r3, r4;
+
+  r0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 + (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 + (uint128_t) f4 * g1_19;
+  r1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0    + (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 + (uint128_t) f4 * g2_19;
+  r2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1    + (uint128_t) f2 * g0    + (uint128_t) f3 * g4_19 + (uint128_t) f4 * g3_19;
+  r3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2    + (uint128_t) f2 * g1    + (uint128_t) f3 * g0    + (uint128_t) f4 * g4_19;
+  r4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3    + (uint128_t) f2 * g2    + (uint128_t) f3 * g1    + (uint128_t) f4 * g0;
+
+  fe51_reduce(h, r0, r1, r2, r3, r4);
+}
+
+/*
+h = f * f
+Can overlap h with f.
+*/
+
+void fe51_sq(fe51 h,fe51 f)
+{
+  uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  uint64_t f0_2 = 2 * f0;
+  uint64_t f1_2 = 2 * f1;
+  uint64_t f3_19 = 19 * f3;
+  uint64_t f4_19 = 19 * f4;
+  uint128_t r0, r1, r2, r3, r4;
+
+  r0 = (uint128_t) f0   * f0 + (uint128_t) (2 * f1) * f4_19 + (uint128_t) (2 * f2) * f3_19;
+  r1 = (uint128_t) f0_2 * f1 + (uint128_t) (2 * f2) * f4_19 + (uint128_t) f3 * f3_19;
+  r2 = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1          + (uint128_t) (2 * f3) * f4_19;
+  r3 = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2        + (uint128_t) f4 * f4_19;
+  r4 = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3        + (uint128_t) f2 * f2;
+
+  fe51_reduce(h, r0, r1, r2, r3, r4);
+}
+
+/*
+h = f * 121666
+Can overlap h with f.
+*/
+
+void fe51_mul121666(fe51 h,fe51 f)
+{
+  fe51_reduce(h,
+              (uint128_t) f[0] * 121666,
+              (uint128_t) f[1] * 121666,
+              (uint128_t) f[2] * 121666,
+              (uint128_t) f[3] * 121666,
+              (uint128_t) f[4] * 121666);
+}
+
+/* pow225521.h is written against the fe_ names. */
+#define fe_sq fe51_sq
+#define fe_mul fe51_mul
+
+void fe51_invert(fe51 out,fe51 z)
+{
+  fe51 t0;
+  fe51 t1;
+  fe51 t2;
+  fe51 t3;
+  int i;
+
+#include "pow225521.h"
+
+  return;
+}
+
+#endif
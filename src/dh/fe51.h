@@ -0,0 +1,42 @@
+#ifndef FE51_H
+#define FE51_H
+
+#include <stdint.h>
+
+/*
+fe51 is available where the compiler has a 128-bit integer type.
+Here the field is \Z/(2^255-19).
+An element t, entries t[0]...t[4], represents the integer
+t[0]+2^51 t[1]+2^102 t[2]+2^153 t[3]+2^204 t[4].
+fe51_mul, fe51_sq and fe51_mul121666 accept entries below 2^54 and return
+entries below 2^52; fe51_add and fe51_sub accept entries below 2^52.
+*/
+
+#if defined __SIZEOF_INT128__
+#define FE51_AVAILABLE 1
+#else
+#define FE51_AVAILABLE 0
+#endif
+
+#if FE51_AVAILABLE
+
+typedef uint64_t fe51[5];
+
+extern void fe51_frombytes(fe51,const unsigned char *);
+extern void fe51_tobytes(unsigned char *,fe51);
+
+extern void fe51_copy(fe51,fe51);
+extern void fe51_0(fe51);
+extern void fe51_1(fe51);
+extern void fe51_cswap(fe51,fe51,unsigned int);
+
+extern void fe51_add(fe51,fe51,fe51);
+extern void fe51_sub(fe51,fe51,fe51);
+extern void fe51_mul(fe51,fe51,fe51);
+extern void fe51_sq(fe51,fe51);
+extern void fe51_mul121666(fe51,fe51);
+extern void fe51_invert(fe51,fe51);
+
+#endif
+
+#endif
@@ -1,10 +1,10 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = 0
 */
 
-void fe_0(fe h)
+void fe25_0(fe25 h)
 {
   h[0] = 0;
   h[1] = 0;
@@ -1,10 +1,10 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = 1
 */
 
-void fe_1(fe h)
+void fe25_1(fe25 h)
 {
   h[0] = 1;
   h[1] = 0;
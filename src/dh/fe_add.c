@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = f + g
@@ -12,7 +12,7 @@ Postconditions:
    |h| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc.
 */
 
-void fe_add(fe h,fe f,fe g)
+void fe25_add(fe25 h,fe25 f,fe25 g)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
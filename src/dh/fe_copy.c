@@ -1,10 +1,10 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = f
 */
 
-void fe_copy(fe h,fe f)
+void fe25_copy(fe25 h,fe25 f)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
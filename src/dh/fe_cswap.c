@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 Replace (f,g) with (g,f) if b == 1;
@@ -7,7 +7,7 @@ replace (f,g) with (f,g) if b == 0.
 Preconditions: b in {0,1}.
 */
 
-void fe_cswap(fe f,fe g,unsigned int b)
+void fe25_cswap(fe25 f,fe25 g,unsigned int b)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
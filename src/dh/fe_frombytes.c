@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 static uint64_t load_3(const unsigned char *in)
 {
@@ -19,7 +19,7 @@ static uint64_t load_4(const unsigned char *in)
   return result;
 }
 
-void fe_frombytes(fe h,const unsigned char *s)
+void fe25_frombytes(fe25 h,const unsigned char *s)
 {
   int64_t h0 = load_4(s);
   int64_t h1 = load_3(s + 4) << 6;
@@ -1,11 +1,15 @@
-#include "fe.h"
+#include "fe25.h"
 
-void fe_invert(fe out,fe z)
+/* pow225521.h is written against the fe_ names. */
+#define fe_sq fe25_sq
+#define fe_mul fe25_mul
+
+void fe25_invert(fe25 out,fe25 z)
 {
-  fe t0;
-  fe t1;
-  fe t2;
-  fe t3;
+  fe25 t0;
+  fe25 t1;
+  fe25 t2;
+  fe25 t3;
   int i;
 
 #include "pow225521.h"
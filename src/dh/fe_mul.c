@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = f * g
@@ -32,7 +32,7 @@ Can get away with 11 carries, but then data flow is much deeper.
 With tighter constraints on inputs can squeeze carries into int32.
 */
 
-void fe_mul(fe h,fe f,fe g)
+void fe25_mul(fe25 h,fe25 f,fe25 g)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = f * 121666
@@ -11,7 +11,7 @@ Postconditions:
    |h| bounded by 1.1*2^25,1.1*2^24,1.1*2^25,1.1*2^24,etc.
 */
 
-void fe_mul121666(fe h,fe f)
+void fe25_mul121666(fe25 h,fe25 f)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 h = f * f
@@ -15,7 +15,7 @@ Postconditions:
 See fe_mul.c for discussion of implementation strategy.
 */
 
-void fe_sq(fe h,fe f)
+void fe25_sq(fe25 h,fe25 f)
 {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
@@ -1,4 +1,4 @@
-#include "fe.h"
+#include "fe25.h"
 
 /*
 Preconditions:
@@ -25,7 +25,7 @@ Proof:
   so floor(2^(-255)(h + 19 2^(-25) h9 + 2^(-1))) = q.
 */
 
-void fe_tobytes(unsigned char *s,fe h)
+void fe25_tobytes(unsigned char *s,fe25 h)
 {
   int32_t h0 = h[0];
   int32_t h1 = h[1];
@@ -1,12 +1,21 @@
 
 #include "nike_api.h"
 #include "curve25519.h"
+#include "scalarmult.h"
 #include "fips202.h"
 
+#include <string.h>
+
 int nike_keygen(nike_sk *sk, nike_pk *pk){
     return dh_keypair(sk->sk, pk->pk);
 }
 
+int nike_keygen_ctx(nike_sk *sk, nike_pk *pk, prng *ctx){
+    randombytes_ctx(ctx, sk->sk, NIKE_SECRETKEY_BYTES);
+    scalarmult_base(pk->pk, sk->sk);
+    return 0;
+}
+
 int nike_sdk(nike_s *s, const nike_sk *sk, const nike_pk *pk){
     unsigned char buff[DH_BYTES];
     dh(buff, sk->sk, pk->pk);
@@ -14,3 +23,29 @@ int nike_sdk(nike_s *s, const nike_sk *sk, const nike_pk *pk){
     return 0;
 }
 
+int nike_sdk_batch(nike_s *s, const nike_sk *sk, const nike_pk *pk, size_t n){
+    unsigned char sks[4 * DH_SECRETKEY_BYTES];
+    unsigned char pks[4 * DH_PUBLICKEY_BYTES];
+    unsigned char buff[4 * DH_BYTES];
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4){
+        for(size_t j = 0; j < 4; j++){
+            memcpy(sks + j * DH_SECRETKEY_BYTES, sk[i + j].sk, DH_SECRETKEY_BYTES);
+            memcpy(pks + j * DH_PUBLICKEY_BYTES, pk[i + j].pk, DH_PUBLICKEY_BYTES);
+        }
+        scalarmult_x4(buff, sks, pks);
+        for(size_t j = 0; j < 4; j++){
+            sha3_512((uint8_t*)s[i + j].s, buff + j * DH_BYTES, DH_BYTES);
+        }
+    }
+    for(size_t j = 0; i + j < n; j++){
+        memcpy(sks + j * DH_SECRETKEY_BYTES, sk[i + j].sk, DH_SECRETKEY_BYTES);
+        memcpy(pks + j * DH_PUBLICKEY_BYTES, pk[i + j].pk, DH_PUBLICKEY_BYTES);
+    }
+    scalarmult_many(buff, sks, pks, n - i);
+    for(; i < n; i++){
+        sha3_512((uint8_t*)s[i].s, buff + (i % 4) * DH_BYTES, DH_BYTES);
+    }
+    return 0;
+}
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "randombytes.h"
+
 #define NIKE_PUBLICKEY_BYTES ((size_t)32)
 #define NIKE_SECRETKEY_BYTES ((size_t)32)
 #define NIKE_BYTES ((size_t)64)
@@ -21,7 +23,13 @@ typedef struct {
 } nike_s;
 
 int nike_keygen(nike_sk *sk, nike_pk *pk);
+// nike_keygen with the secret key drawn from ctx instead of the current
+// context.
+int nike_keygen_ctx(nike_sk *sk, nike_pk *pk, prng *ctx);
 int nike_sdk(nike_s *s, const nike_sk *sk, const nike_pk *pk);
+// s[i] = nike_sdk(sk[i], pk[i]) for i < n, with the ladders run four at a
+// time by scalarmult_x4; a tail of fewer than four shares one inversion.
+int nike_sdk_batch(nike_s *s, const nike_sk *sk, const nike_pk *pk, size_t n);
 
 #endif
 
@@ -1,8 +1,18 @@
 #ifndef SCALARMULT_H
 #define SCALARMULT_H
 
+#include <stddef.h>
+
 int scalarmult(unsigned char *q, const unsigned char *n, const unsigned char *p);
 int scalarmult_base(unsigned char *q,const unsigned char *n);
+int scalarmult_base_ladder(unsigned char *q,const unsigned char *n);
+
+/* count ladders on consecutive 32-byte q, n and p, sharing the inversion. */
+int scalarmult_many(unsigned char *q, const unsigned char *n, const unsigned char *p, size_t count);
+
+/* Four ladders on consecutive 32-byte q, n and p. */
+int scalarmult_x4(unsigned char *q,const unsigned char *n,const unsigned char *p);
+int scalarmult_x4_ref(unsigned char *q,const unsigned char *n,const unsigned char *p);
 
 #endif
 
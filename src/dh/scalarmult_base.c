@@ -0,0 +1,379 @@
+#include <pthread.h>
+
+#include "scalarmult.h"
+#include "fe.h"
+
+/*
+Fixed-base scalar multiplication by the X25519 base point u = 9.
+
+The scalar is multiplied with the base point B of the birationally
+equivalent twisted Edwards curve -x^2 + y^2 = 1 + d x^2 y^2 (y = 4/5), and
+the result is mapped back with u = (1 + y)/(1 - y) = (Z + Y)/(Z - Y).
+
+The clamped scalar is recoded into N = ceil(256/W) signed digits in
+[-2^(W-1), 2^(W-1)]. Row i of the table holds the affine multiples
+1..2^(W-1) of 2^(W*S*i) B, so that digits i*S + j for all i share a
+single pass: the S passes are joined by W doublings each. That is N mixed
+additions and (S-1)*W doublings for ceil(N/S) * 2^(W-1) table entries of
+three field elements. Every lookup reads a whole row and negates with
+masked moves, so the memory access pattern does not depend on the
+scalar.
+
+The table is built on first use, under pthread_once.
+*/
+
+#ifndef DH_BASE_WINDOW
+#define DH_BASE_WINDOW 4
+#endif
+
+#ifndef DH_BASE_SPACING
+#define DH_BASE_SPACING 2
+#endif
+
+#if DH_BASE_WINDOW < 2 || DH_BASE_WINDOW > 7
+#error "DH_BASE_WINDOW must be between 2 and 7"
+#endif
+
+#if DH_BASE_SPACING < 1
+#error "DH_BASE_SPACING must be positive"
+#endif
+
+#define BASE_DIGITS ((256 + DH_BASE_WINDOW - 1) / DH_BASE_WINDOW)
+#define BASE_ROWS ((BASE_DIGITS + DH_BASE_SPACING - 1) / DH_BASE_SPACING)
+#define BASE_ENTRIES (1 << (DH_BASE_WINDOW - 1))
+
+/*
+ge_p2 (projective): (X:Y:Z) satisfying x=X/Z, y=Y/Z
+ge_p3 (extended): (X:Y:Z:T) satisfying x=X/Z, y=Y/Z, XY=ZT
+ge_p1p1 (completed): ((X:Z),(Y:T)) satisfying x=X/Z, y=Y/T
+ge_precomp (affine, for mixed additions): (y+x,y-x,2dxy)
+*/
+
+typedef struct {
+  fe X;
+  fe Y;
+  fe Z;
+} ge_p2;
+
+typedef struct {
+  fe X;
+  fe Y;
+  fe Z;
+  fe T;
+} ge_p3;
+
+typedef struct {
+  fe X;
+  fe Y;
+  fe Z;
+  fe T;
+} ge_p1p1;
+
+typedef struct {
+  fe yplusx;
+  fe yminusx;
+  fe xy2d;
+} ge_precomp;
+
+static ge_precomp base_table[BASE_ROWS][BASE_ENTRIES];
+static pthread_once_t base_table_once = PTHREAD_ONCE_INIT;
+
+/* x coordinate of B; the y coordinate 4/5 is computed. */
+static const unsigned char base_x[32] = {
+  0x1a,0xd5,0x25,0x8f,0x60,0x2d,0x56,0xc9,0xb2,0xa7,0x25,0x95,0x60,0xc7,0x2c,0x69,
+  0x5c,0xdc,0xd6,0xfd,0x31,0xe2,0xa4,0xc0,0xfe,0x53,0x6e,0xcd,0xd3,0x36,0x69,0x21
+};
+
+static void fe_small(fe h,unsigned int v)
+{
+  unsigned char s[32] = {0};
+
+  s[0] = v & 255;
+  s[1] = (v >> 8) & 255;
+  s[2] = (v >> 16) & 255;
+  fe_frombytes(h,s);
+}
+
+/*
+Replace t with u if b == 1;
+replace t with t if b == 0.
+
+Works on the bytes, so that it is a few vector instructions for either
+field representation.
+
+Preconditions: b in {0,1}.
+*/
+
+static void ge_precomp_cmov(ge_precomp *t,const ge_precomp *u,unsigned int b)
+{
+  unsigned char *x = (unsigned char *) t;
+  const unsigned char *y = (const unsigned char *) u;
+  unsigned char mask = -b;
+  unsigned int i;
+
+  for (i = 0;i < sizeof(ge_precomp);++i) x[i] ^= (x[i] ^ y[i]) & mask;
+}
+
+static void ge_p3_0(ge_p3 *h)
+{
+  fe_0(h->X);
+  fe_1(h->Y);
+  fe_1(h->Z);
+  fe_0(h->T);
+}
+
+static void ge_p1p1_to_p2(ge_p2 *r,ge_p1p1 *p)
+{
+  fe_mul(r->X,p->X,p->T);
+  fe_mul(r->Y,p->Y,p->Z);
+  fe_mul(r->Z,p->Z,p->T);
+}
+
+static void ge_p1p1_to_p3(ge_p3 *r,ge_p1p1 *p)
+{
+  fe_mul(r->X,p->X,p->T);
+  fe_mul(r->Y,p->Y,p->Z);
+  fe_mul(r->Z,p->Z,p->T);
+  fe_mul(r->T,p->X,p->Y);
+}
+
+/*
+r = 2 * p
+
+The T coordinate is formed as (2Z^2 + X^2) - Y^2, with 2Z^2 as Z * 2Z, so
+that both the fe25 and the fe51 input bounds of fe_mul hold.
+*/
+
+static void ge_p2_dbl(ge_p1p1 *r,ge_p2 *p)
+{
+  fe xx;
+  fe yy;
+  fe t0;
+
+  fe_sq(xx,p->X);
+  fe_sq(yy,p->Y);
+  fe_add(t0,p->Z,p->Z);
+  fe_mul(r->T,p->Z,t0);
+  fe_add(r->T,r->T,xx);
+  fe_sub(r->T,r->T,yy);
+  fe_add(t0,p->X,p->Y);
+  fe_sq(t0,t0);
+  fe_add(r->Y,yy,xx);
+  fe_sub(r->Z,yy,xx);
+  fe_sub(r->X,t0,r->Y);
+}
+
+/*
+r = p + q
+*/
+
+static void ge_madd(ge_p1p1 *r,ge_p3 *p,ge_precomp *q)
+{
+  fe t0;
+
+  fe_add(r->X,p->Y,p->X);
+  fe_sub(r->Y,p->Y,p->X);
+  fe_mul(r->Z,r->X,q->yplusx);
+  fe_mul(r->Y,r->Y,q->yminusx);
+  fe_mul(r->T,q->xy2d,p->T);
+  fe_add(t0,p->Z,p->Z);
+  fe_sub(r->X,r->Z,r->Y);
+  fe_add(r->Y,r->Z,r->Y);
+  fe_add(r->Z,t0,r->T);
+  fe_sub(r->T,t0,r->T);
+}
+
+/*
+r = p + q, with d2 = 2d. Only used to build the table.
+*/
+
+static void ge_add(ge_p3 *r,ge_p3 *p,ge_p3 *q,fe d2)
+{
+  ge_p1p1 t;
+  fe a;
+  fe b;
+
+  fe_sub(a,p->Y,p->X);
+  fe_sub(b,q->Y,q->X);
+  fe_mul(a,a,b);
+  fe_add(t.Y,p->Y,p->X);
+  fe_add(b,q->Y,q->X);
+  fe_mul(b,t.Y,b);
+  fe_mul(t.T,p->T,d2);
+  fe_mul(t.T,t.T,q->T);
+  fe_mul(t.Z,p->Z,q->Z);
+  fe_add(t.Z,t.Z,t.Z);
+  fe_sub(t.X,b,a);
+  fe_add(t.Y,b,a);
+  fe_sub(a,t.Z,t.T);
+  fe_add(t.Z,t.Z,t.T);
+  fe_copy(t.T,a);
+  ge_p1p1_to_p3(r,&t);
+}
+
+static void ge_p3_dbl(ge_p3 *r,ge_p3 *p)
+{
+  ge_p2 q;
+  ge_p1p1 t;
+
+  fe_copy(q.X,p->X);
+  fe_copy(q.Y,p->Y);
+  fe_copy(q.Z,p->Z);
+  ge_p2_dbl(&t,&q);
+  ge_p1p1_to_p3(r,&t);
+}
+
+/*
+Row i of the table gets the multiples 1..BASE_ENTRIES of 2^(W*S*i) B,
+normalized with a single inversion per row.
+*/
+
+static void base_table_init(void)
+{
+  ge_p3 row[BASE_ENTRIES];
+  fe acc[BASE_ENTRIES];
+  ge_p3 p;
+  fe d2;
+  fe t;
+  fe x;
+  fe y;
+  int i;
+  int j;
+  int k;
+
+  fe_small(d2,121666);
+  fe_invert(d2,d2);
+  fe_small(t,121665);
+  fe_mul(d2,d2,t);
+  fe_0(t);
+  fe_sub(d2,t,d2);
+  fe_add(d2,d2,d2);
+
+  fe_small(p.Y,5);
+  fe_invert(p.Y,p.Y);
+  fe_small(t,4);
+  fe_mul(p.Y,p.Y,t);
+  fe_frombytes(p.X,base_x);
+  fe_1(p.Z);
+  fe_mul(p.T,p.X,p.Y);
+
+  for (i = 0;i < BASE_ROWS;++i) {
+    row[0] = p;
+    for (j = 1;j < BASE_ENTRIES;++j) ge_add(&row[j],&row[j - 1],&p,d2);
+
+    fe_copy(acc[0],row[0].Z);
+    for (j = 1;j < BASE_ENTRIES;++j) fe_mul(acc[j],acc[j - 1],row[j].Z);
+    fe_invert(t,acc[BASE_ENTRIES - 1]);
+    for (j = BASE_ENTRIES - 1;j >= 0;--j) {
+      if (j > 0) {
+        fe_mul(acc[j],acc[j - 1],t);
+        fe_mul(t,t,row[j].Z);
+      } else {
+        fe_copy(acc[j],t);
+      }
+      fe_mul(x,row[j].X,acc[j]);
+      fe_mul(y,row[j].Y,acc[j]);
+      fe_add(base_table[i][j].yplusx,y,x);
+      fe_sub(base_table[i][j].yminusx,y,x);
+      fe_mul(base_table[i][j].xy2d,x,y);
+      fe_mul(base_table[i][j].xy2d,base_table[i][j].xy2d,d2);
+    }
+
+    for (k = 0;k < DH_BASE_WINDOW * DH_BASE_SPACING;++k) ge_p3_dbl(&p,&p);
+  }
+}
+
+static unsigned int equal(unsigned int b,unsigned int c)
+{
+  unsigned int x = b ^ c;
+
+  x -= 1;
+  return x >> 31;
+}
+
+/*
+t = b * row[0], where row[j] holds (j+1) times a point.
+
+Preconditions: b in [-BASE_ENTRIES, BASE_ENTRIES].
+*/
+
+static void base_select(ge_precomp *t,ge_precomp *row,int b)
+{
+  unsigned int bnegative = ((unsigned int) b) >> 31;
+  unsigned int babs = b - (((-bnegative) & b) << 1);
+  ge_precomp minus;
+  int j;
+
+  fe_1(t->yplusx);
+  fe_1(t->yminusx);
+  fe_0(t->xy2d);
+  for (j = 0;j < BASE_ENTRIES;++j) ge_precomp_cmov(t,&row[j],equal(babs,j + 1));
+  fe_copy(minus.yplusx,t->yminusx);
+  fe_copy(minus.yminusx,t->yplusx);
+  fe_0(minus.xy2d);
+  fe_sub(minus.xy2d,minus.xy2d,t->xy2d);
+  ge_precomp_cmov(t,&minus,bnegative);
+}
+
+int scalarmult_base(unsigned char *q,const unsigned char *n)
+{
+  unsigned char e[34];
+  int digit[BASE_DIGITS];
+  int carry;
+  unsigned int i;
+  int j;
+  int k;
+  ge_precomp t;
+  ge_p1p1 r;
+  ge_p2 s;
+  ge_p3 h;
+  fe num;
+  fe den;
+
+  pthread_once(&base_table_once,base_table_init);
+
+  for (i = 0;i < 32;++i) e[i] = n[i];
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+  e[32] = 0;
+  e[33] = 0;
+
+  /* e < 2^255, so the top digit stays at most 2^(W-1) after the carries. */
+  carry = 0;
+  for (i = 0;i < BASE_DIGITS;++i) {
+    unsigned int bit = i * DH_BASE_WINDOW;
+    unsigned int w = e[bit / 8] | ((unsigned int) e[bit / 8 + 1] << 8);
+    digit[i] = ((w >> (bit % 8)) & (BASE_ENTRIES * 2 - 1)) + carry;
+    carry = (digit[i] + BASE_ENTRIES) >> DH_BASE_WINDOW;
+    digit[i] -= carry << DH_BASE_WINDOW;
+  }
+  digit[BASE_DIGITS - 1] += carry << DH_BASE_WINDOW;
+
+  ge_p3_0(&h);
+  for (j = DH_BASE_SPACING - 1;j >= 0;--j) {
+    if (j < DH_BASE_SPACING - 1) {
+      fe_copy(s.X,h.X);
+      fe_copy(s.Y,h.Y);
+      fe_copy(s.Z,h.Z);
+      for (k = 0;k < DH_BASE_WINDOW - 1;++k) {
+        ge_p2_dbl(&r,&s);
+        ge_p1p1_to_p2(&s,&r);
+      }
+      ge_p2_dbl(&r,&s);
+      ge_p1p1_to_p3(&h,&r);
+    }
+    for (i = j;i < BASE_DIGITS;i += DH_BASE_SPACING) {
+      base_select(&t,base_table[i / DH_BASE_SPACING],digit[i]);
+      ge_madd(&r,&h,&t);
+      ge_p1p1_to_p3(&h,&r);
+    }
+  }
+
+  fe_add(num,h.Z,h.Y);
+  fe_sub(den,h.Z,h.Y);
+  fe_invert(den,den);
+  fe_mul(num,num,den);
+  fe_tobytes(q,num);
+  return 0;
+}
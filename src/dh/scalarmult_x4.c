@@ -0,0 +1,424 @@
+#include "scalarmult.h"
+#include "fe51.h"
+
+/*
+Four independent X25519 ladders, q_i = n_i * p_i for i = 0..3, where q, n
+and p hold four consecutive 32-byte strings.
+
+The vector engines keep one field element per lane in ten unsigned limbs
+of 26, 25, 26, ... bits, each in the low half of a 64-bit lane, so that
+the 32x32->64-bit vector multiplication forms every partial product. AVX2
+runs the four ladders at once, NEON two at a time. Bit swaps use per-lane
+masks and every lane runs all 255 steps, so the timing does not depend on
+any of the scalars. The final encoding goes through fe51, hence the
+engines require FE51_AVAILABLE.
+
+Define SCALARMULT_X4_AVX2 to 0 in order to disable the AVX2 engine, which
+is gated at runtime on CPU support. Define SCALARMULT_X4_NEON to 1 on
+aarch64 to enable the NEON engine; it is off by default until it has been
+built and tested on an aarch64 target.
+*/
+
+#ifndef SCALARMULT_X4_AVX2
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__) && FE51_AVAILABLE
+#define SCALARMULT_X4_AVX2 1
+#else
+#define SCALARMULT_X4_AVX2 0
+#endif
+#endif
+
+#ifndef SCALARMULT_X4_NEON
+#define SCALARMULT_X4_NEON 0
+#endif
+#if SCALARMULT_X4_NEON && !(defined __aarch64__ && (defined __GNUC__ || defined __clang__) && FE51_AVAILABLE)
+#error "SCALARMULT_X4_NEON needs an aarch64 target, GCC or Clang and FE51_AVAILABLE"
+#endif
+
+int scalarmult_x4_ref(unsigned char *q,const unsigned char *n,const unsigned char *p)
+{
+  int i;
+
+  for (i = 0;i < 4;++i) scalarmult(q + 32 * i,n + 32 * i,p + 32 * i);
+  return 0;
+}
+
+#if SCALARMULT_X4_AVX2
+
+#include <immintrin.h>
+
+#define TARGET_X4 __attribute__((target("avx2")))
+#define INLINE_X4 __attribute__((target("avx2"),always_inline)) inline
+#define LANES 4
+
+typedef __m256i vec;
+
+#define vec_add(a,b) _mm256_add_epi64(a,b)
+#define vec_sub(a,b) _mm256_sub_epi64(a,b)
+#define vec_mul(a,b) _mm256_mul_epu32(a,b)
+#define vec_and(a,b) _mm256_and_si256(a,b)
+#define vec_xor(a,b) _mm256_xor_si256(a,b)
+#define vec_shr(a,c) _mm256_srli_epi64(a,c)
+#define vec_shl(a,c) _mm256_slli_epi64(a,c)
+#define vec_set(x) _mm256_set1_epi64x((long long) (x))
+#define vec_load(s) _mm256_loadu_si256((const __m256i *) (s))
+#define vec_store(s,a) _mm256_storeu_si256((__m256i *) (s),a)
+
+#elif SCALARMULT_X4_NEON
+
+#include <arm_neon.h>
+
+#define TARGET_X4
+#define INLINE_X4 __attribute__((always_inline)) inline
+#define LANES 2
+
+typedef uint64x2_t vec;
+
+#define vec_add(a,b) vaddq_u64(a,b)
+#define vec_sub(a,b) vsubq_u64(a,b)
+#define vec_mul(a,b) vmull_u32(vmovn_u64(a),vmovn_u64(b))
+#define vec_and(a,b) vandq_u64(a,b)
+#define vec_xor(a,b) veorq_u64(a,b)
+#define vec_shr(a,c) vshrq_n_u64(a,c)
+#define vec_shl(a,c) vshlq_n_u64(a,c)
+#define vec_set(x) vdupq_n_u64(x)
+#define vec_load(s) vld1q_u64(s)
+#define vec_store(s,a) vst1q_u64(s,a)
+
+#endif
+
+#if SCALARMULT_X4_AVX2 || SCALARMULT_X4_NEON
+
+/*
+fev holds LANES field elements, limb i of every lane in vector i.
+Limb i weighs 2^ceil(25.5 i). After fev_carry, even limbs are below 2^26
+and odd limbs below 2^25 + 2^17; fev_add then gives limbs below 2^27 and
+fev_sub (which adds 2p) limbs below 1.5 * 2^27. fev_mul and fev_sq accept
+either, which keeps 19 times a limb within 32 bits and every column sum
+within 64 bits.
+*/
+
+typedef vec fev[10];
+
+static const unsigned int limb_bits[10] = {26,25,26,25,26,25,26,25,26,25};
+
+static uint64_t load64(const unsigned char *in)
+{
+  uint64_t r = 0;
+  int i;
+
+  for (i = 7;i >= 0;--i) r = (r << 8) | in[i];
+  return r;
+}
+
+/*
+Ignores top bit of each s.
+*/
+
+INLINE_X4
+static void fev_frombytes(fev h,const unsigned char *s)
+{
+  uint64_t t[10][LANES];
+  unsigned char b[40];
+  unsigned int i;
+  unsigned int l;
+  unsigned int pos;
+
+  for (l = 0;l < LANES;++l) {
+    for (i = 0;i < 32;++i) b[i] = s[32 * l + i];
+    for (i = 32;i < 40;++i) b[i] = 0;
+    b[31] &= 127;
+    pos = 0;
+    for (i = 0;i < 10;++i) {
+      t[i][l] = (load64(b + pos / 8) >> (pos % 8)) & (((uint64_t) 1 << limb_bits[i]) - 1);
+      pos += limb_bits[i];
+    }
+  }
+  for (i = 0;i < 10;++i) h[i] = vec_load(t[i]);
+}
+
+INLINE_X4
+static void fev_tobytes(unsigned char *s,fev h)
+{
+  uint64_t t[10][LANES];
+  fe51 g;
+  unsigned int i;
+  unsigned int l;
+
+  for (i = 0;i < 10;++i) vec_store(t[i],h[i]);
+  for (l = 0;l < LANES;++l) {
+    for (i = 0;i < 5;++i) g[i] = t[2 * i][l] + (t[2 * i + 1][l] << 26);
+    fe51_tobytes(s + 32 * l,g);
+  }
+}
+
+INLINE_X4
+static void fev_copy(fev h,fev f)
+{
+  int i;
+
+  for (i = 0;i < 10;++i) h[i] = f[i];
+}
+
+INLINE_X4
+static void fev_0(fev h)
+{
+  int i;
+
+  for (i = 0;i < 10;++i) h[i] = vec_set(0);
+}
+
+INLINE_X4
+static void fev_1(fev h)
+{
+  fev_0(h);
+  h[0] = vec_set(1);
+}
+
+/*
+Replace (f,g) with (g,f) in the lanes where b is all ones;
+leave the lanes where b is zero.
+*/
+
+INLINE_X4
+static void fev_cswap(fev f,fev g,vec b)
+{
+  vec x;
+  int i;
+
+  for (i = 0;i < 10;++i) {
+    x = vec_and(vec_xor(f[i],g[i]),b);
+    f[i] = vec_xor(f[i],x);
+    g[i] = vec_xor(g[i],x);
+  }
+}
+
+INLINE_X4
+static void fev_add(fev h,fev f,fev g)
+{
+  int i;
+
+  for (i = 0;i < 10;++i) h[i] = vec_add(f[i],g[i]);
+}
+
+/*
+h = f - g + 2p
+*/
+
+INLINE_X4
+static void fev_sub(fev h,fev f,fev g)
+{
+  vec p0 = vec_set(0x7ffffda);
+  vec p26 = vec_set(0x7fffffe);
+  vec p25 = vec_set(0x3fffffe);
+  int i;
+
+  h[0] = vec_sub(vec_add(f[0],p0),g[0]);
+  for (i = 1;i < 10;++i) h[i] = vec_sub(vec_add(f[i],(i & 1) ? p25 : p26),g[i]);
+}
+
+#define CARRY(i,j,bits) { \
+  c = vec_shr(h[i],bits); \
+  h[j] = vec_add(h[j],c); \
+  h[i] = vec_and(h[i],vec_set((1 << bits) - 1)); \
+}
+
+/*
+Carries the 64-bit column sums h into limbs, in the ref10 order.
+*/
+
+INLINE_X4
+static void fev_carry(fev h)
+{
+  vec c;
+
+  CARRY(0,1,26);
+  CARRY(4,5,26);
+  CARRY(1,2,25);
+  CARRY(5,6,25);
+  CARRY(2,3,26);
+  CARRY(6,7,26);
+  CARRY(3,4,25);
+  CARRY(7,8,25);
+  CARRY(4,5,26);
+  CARRY(8,9,26);
+  c = vec_shr(h[9],25);
+  h[9] = vec_and(h[9],vec_set((1 << 25) - 1));
+  h[0] = vec_add(h[0],vec_add(c,vec_add(vec_shl(c,1),vec_shl(c,4))));
+  CARRY(0,1,26);
+}
+
+#undef CARRY
+
+/*
+h = f * g
+
+Limbs i and j with i + j >= 10 wrap around with a factor 19, and two odd
+limbs meet with a factor 2.
+*/
+
+INLINE_X4
+static void fev_mul(fev h,fev f,fev g)
+{
+  vec f2[10];
+  vec g19[10];
+  vec r[10];
+  int i;
+  int k;
+
+  for (i = 0;i < 10;++i) {
+    f2[i] = vec_add(f[i],f[i]);
+    g19[i] = vec_add(vec_add(g[i],vec_shl(g[i],1)),vec_shl(g[i],4));
+  }
+#ifdef __GNUC__
+#pragma GCC unroll 10
+#endif
+  for (k = 0;k < 10;++k) {
+    r[k] = vec_mul(f[0],g[k]);
+#ifdef __GNUC__
+#pragma GCC unroll 10
+#endif
+    for (i = 1;i < 10;++i) {
+      vec a = ((i & 1) && !(k & 1)) ? f2[i] : f[i];
+      vec b = (i > k) ? g19[k + 10 - i] : g[k - i];
+      r[k] = vec_add(r[k],vec_mul(a,b));
+    }
+  }
+  fev_copy(h,r);
+  fev_carry(h);
+}
+
+/*
+h = f^2
+*/
+
+INLINE_X4
+static void fev_sq(fev h,fev f)
+{
+  vec f2[10];
+  vec f4[10];
+  vec f19[10];
+  vec r[10];
+  int i;
+  int j;
+
+  for (i = 0;i < 10;++i) {
+    f2[i] = vec_add(f[i],f[i]);
+    f4[i] = vec_add(f2[i],f2[i]);
+    f19[i] = vec_add(vec_add(f[i],vec_shl(f[i],1)),vec_shl(f[i],4));
+    r[i] = vec_set(0);
+  }
+#ifdef __GNUC__
+#pragma GCC unroll 10
+#endif
+  for (i = 0;i < 10;++i) {
+#ifdef __GNUC__
+#pragma GCC unroll 10
+#endif
+    for (j = i;j < 10;++j) {
+      int odd = (i & 1) && (j & 1);
+      vec a = (i == j) ? (odd ? f2[i] : f[i]) : (odd ? f4[i] : f2[i]);
+      vec b = (i + j >= 10) ? f19[j] : f[j];
+      r[(i + j) % 10] = vec_add(r[(i + j) % 10],vec_mul(a,b));
+    }
+  }
+  fev_copy(h,r);
+  fev_carry(h);
+}
+
+INLINE_X4
+static void fev_mul121666(fev h,fev f)
+{
+  vec a24 = vec_set(121666);
+  int i;
+
+  for (i = 0;i < 10;++i) h[i] = vec_mul(f[i],a24);
+  fev_carry(h);
+}
+
+/* montgomery.h and pow225521.h are written against the fe_ names. */
+#define fe fev
+#define fe_copy fev_copy
+#define fe_add fev_add
+#define fe_sub fev_sub
+#define fe_mul fev_mul
+#define fe_sq fev_sq
+#define fe_mul121666 fev_mul121666
+
+INLINE_X4
+static void fev_invert(fev out,fev z)
+{
+  fev t0;
+  fev t1;
+  fev t2;
+  fev t3;
+  int i;
+
+#include "pow225521.h"
+
+  return;
+}
+
+TARGET_X4
+static void scalarmult_lanes(unsigned char *q,const unsigned char *n,const unsigned char *p)
+{
+  unsigned char e[LANES][32];
+  uint64_t bit[LANES];
+  unsigned int i;
+  unsigned int l;
+  fev x1;
+  fev x2;
+  fev z2;
+  fev x3;
+  fev z3;
+  fev tmp0;
+  fev tmp1;
+  int pos;
+  vec swap;
+  vec b;
+
+  for (l = 0;l < LANES;++l) {
+    for (i = 0;i < 32;++i) e[l][i] = n[32 * l + i];
+    e[l][0] &= 248;
+    e[l][31] &= 127;
+    e[l][31] |= 64;
+  }
+  fev_frombytes(x1,p);
+  fev_1(x2);
+  fev_0(z2);
+  fev_copy(x3,x1);
+  fev_1(z3);
+
+  swap = vec_set(0);
+  for (pos = 254;pos >= 0;--pos) {
+    for (l = 0;l < LANES;++l) bit[l] = (e[l][pos / 8] >> (pos & 7)) & 1;
+    b = vec_sub(vec_set(0),vec_load(bit));
+    swap = vec_xor(swap,b);
+    fev_cswap(x2,x3,swap);
+    fev_cswap(z2,z3,swap);
+    swap = b;
+#include "montgomery.h"
+  }
+  fev_cswap(x2,x3,swap);
+  fev_cswap(z2,z3,swap);
+
+  fev_invert(z2,z2);
+  fev_mul(x2,x2,z2);
+  fev_tobytes(q,x2);
+}
+
+#endif
+
+int scalarmult_x4(unsigned char *q,const unsigned char *n,const unsigned char *p)
+{
+#if SCALARMULT_X4_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    scalarmult_lanes(q,n,p);
+    return 0;
+  }
+#elif SCALARMULT_X4_NEON
+  scalarmult_lanes(q,n,p);
+  scalarmult_lanes(q + 64,n + 64,p + 64);
+  return 0;
+#endif
+  return scalarmult_x4_ref(q,n,p);
+}
@@ -0,0 +1,531 @@
+// SIMD NTT shared by GandalfFalcon/poly.c and GandalfMitaka/poly.c.
+//
+// Included once by each poly.c after its scalar NTT, like samplerZ_table.c
+// in gandalf_samplerZ.c; it is not compiled on its own. The kernels take
+// Q, the Barrett and Montgomery constants and the twiddle tables from the
+// including instance's poly.h and poly.c, which are identical for both.
+
+/* Define GANDALF_POLY_AVX2 to 0 in order to disable the AVX2 NTT.
+   The AVX2 code is gated at runtime on CPU support. */
+#ifndef GANDALF_POLY_AVX2
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define GANDALF_POLY_AVX2   1
+#else
+#define GANDALF_POLY_AVX2   0
+#endif
+#endif
+
+/* Define GANDALF_POLY_NEON to 1 on aarch64 to enable the NEON NTT. It is
+   off by default until it has been built and tested on an aarch64 target. */
+#ifndef GANDALF_POLY_NEON
+#define GANDALF_POLY_NEON   0
+#endif
+#if GANDALF_POLY_NEON && !(defined __aarch64__ && defined __ARM_NEON)
+#error "GANDALF_POLY_NEON needs an aarch64 target with NEON"
+#endif
+
+#if GANDALF_POLY_AVX2
+#include <immintrin.h>
+#define TARGET_POLY_AVX2   __attribute__((target("avx2")))
+#endif
+
+#if GANDALF_POLY_NEON
+#include <arm_neon.h>
+#endif
+
+// ================
+// SIMD NTT
+
+// The vector paths below reproduce poly_NTT_montgomery_generic,
+// poly_iNTT_montgomery_generic and poly_point_mul_generic bit for bit:
+// every product is taken exactly on 64 bits before the Montgomery or
+// Barrett reduction, so both paths give the same int32_t coefficients.
+// Levels with step >= the vector width share one twiddle per vector; the
+// last levels are computed inside blocks of two vectors after a shuffle
+// that puts the butterfly pairs into separate registers.
+
+#if GANDALF_POLY_AVX2
+
+// montgomery_generic((int64_t)a * b) on 8 lanes; the 64-bit products are
+// formed separately on even and odd lanes.
+TARGET_POLY_AVX2
+static inline
+__m256i montgomery_mul_avx2(__m256i a, __m256i b){
+
+    const __m256i qinv = _mm256_set1_epi32(MontgomeryFactor);
+    const __m256i q = _mm256_set1_epi32(Q);
+    __m256i pe, po, te, to;
+
+    pe = _mm256_mul_epi32(a, b);
+    po = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    te = _mm256_mul_epi32(_mm256_mul_epi32(pe, qinv), q);
+    to = _mm256_mul_epi32(_mm256_mul_epi32(po, qinv), q);
+    pe = _mm256_sub_epi64(pe, te);
+    po = _mm256_sub_epi64(po, to);
+
+    return _mm256_blend_epi32(_mm256_srli_epi64(pe, 32), po, 0xAA);
+
+}
+
+// barrett_generic on 8 lanes.
+TARGET_POLY_AVX2
+static inline
+__m256i barrett_avx2(__m256i a){
+
+    const __m256i factor = _mm256_set1_epi32(BarrettFactor);
+    const __m256i round = _mm256_set1_epi64x(1LL << 31);
+    const __m256i q = _mm256_set1_epi32(Q);
+    __m256i he, ho;
+
+    he = _mm256_add_epi64(_mm256_mul_epi32(a, factor), round);
+    ho = _mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), factor), round);
+    he = _mm256_blend_epi32(_mm256_srli_epi64(he, 32), ho, 0xAA);
+
+    return _mm256_sub_epi32(a, _mm256_mullo_epi32(he, q));
+
+}
+
+#define CT_BUTTERFLY_AVX2(a, b, w) do { \
+        __m256i t_ = montgomery_mul_avx2((b), (w)); \
+        (b) = _mm256_sub_epi32((a), t_); \
+        (a) = _mm256_add_epi32((a), t_); \
+    } while(0)
+
+#define GS_BUTTERFLY_AVX2(a, b, w) do { \
+        __m256i t_ = _mm256_sub_epi32((a), (b)); \
+        (a) = _mm256_add_epi32((a), (b)); \
+        (b) = montgomery_mul_avx2(t_, (w)); \
+    } while(0)
+
+// Twiddles of levels 6, 7 and 8 for the 16 coefficients at offset i,
+// ordered as the lanes of the shuffled registers below.
+TARGET_POLY_AVX2
+static inline
+__m256i twiddle_level6_avx2(const int32_t *twiddle_table, size_t i){
+    const int32_t *root_ptr = twiddle_table + 63 + i / 8;
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi32(root_ptr[0])),
+                                   _mm_set1_epi32(root_ptr[1]), 1);
+}
+
+TARGET_POLY_AVX2
+static inline
+__m256i twiddle_level7_avx2(const int32_t *twiddle_table, size_t i){
+    const int32_t *root_ptr = twiddle_table + 127 + i / 4;
+    return _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)root_ptr)),
+                                       _mm256_setr_epi32(0, 0, 2, 2, 1, 1, 3, 3));
+}
+
+TARGET_POLY_AVX2
+static inline
+__m256i twiddle_level8_avx2(const int32_t *twiddle_table, size_t i){
+    const int32_t *root_ptr = twiddle_table + 255 + i / 2;
+    return _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)root_ptr),
+                                       _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+TARGET_POLY_AVX2
+static
+void NTT_montgomery_core_avx2(int32_t *coeffs, size_t level, const int32_t *twiddle_table, int inverse){
+
+    size_t step;
+    const int32_t *root_ptr;
+    __m256i a, b, w;
+
+    step = N >> (level + 1);
+    root_ptr = twiddle_table + ((1u << level) - 1);
+
+    for(size_t i = 0; i < N; i += 2 * step){
+        w = _mm256_set1_epi32(*root_ptr);
+        for(size_t j = i; j < i + step; j += 8){
+            a = _mm256_loadu_si256((const __m256i*)(coeffs + j));
+            b = _mm256_loadu_si256((const __m256i*)(coeffs + j + step));
+            if(inverse){
+                GS_BUTTERFLY_AVX2(a, b, w);
+            }else{
+                CT_BUTTERFLY_AVX2(a, b, w);
+            }
+            _mm256_storeu_si256((__m256i*)(coeffs + j), a);
+            _mm256_storeu_si256((__m256i*)(coeffs + j + step), b);
+        }
+        root_ptr += 1;
+    }
+
+}
+
+TARGET_POLY_AVX2
+static
+void poly_NTT_avx2(poly *src){
+
+    int32_t *coeffs = src->coeffs;
+    const int32_t *twiddle_table = CT_NTT_twiddle_Rmod_table;
+    __m256i x, y, a, b, w;
+
+    for(size_t level = 0; level < 6; level++){
+        NTT_montgomery_core_avx2(coeffs, level, twiddle_table, 0);
+    }
+
+    for(size_t i = 0; i < N; i += 16){
+        x = _mm256_loadu_si256((const __m256i*)(coeffs + i));
+        y = _mm256_loadu_si256((const __m256i*)(coeffs + i + 8));
+
+        // level 6, step 4
+        w = twiddle_level6_avx2(twiddle_table, i);
+        a = _mm256_permute2x128_si256(x, y, 0x20);
+        b = _mm256_permute2x128_si256(x, y, 0x31);
+        CT_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_permute2x128_si256(a, b, 0x20);
+        y = _mm256_permute2x128_si256(a, b, 0x31);
+
+        // level 7, step 2
+        w = twiddle_level7_avx2(twiddle_table, i);
+        a = _mm256_unpacklo_epi64(x, y);
+        b = _mm256_unpackhi_epi64(x, y);
+        CT_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_unpacklo_epi64(a, b);
+        y = _mm256_unpackhi_epi64(a, b);
+
+        // level 8, step 1
+        w = twiddle_level8_avx2(twiddle_table, i);
+        a = _mm256_blend_epi32(x, _mm256_slli_epi64(y, 32), 0xAA);
+        b = _mm256_blend_epi32(_mm256_srli_epi64(x, 32), y, 0xAA);
+        CT_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_blend_epi32(a, _mm256_slli_epi64(b, 32), 0xAA);
+        y = _mm256_blend_epi32(_mm256_srli_epi64(a, 32), b, 0xAA);
+
+        _mm256_storeu_si256((__m256i*)(coeffs + i), x);
+        _mm256_storeu_si256((__m256i*)(coeffs + i + 8), y);
+    }
+
+}
+
+TARGET_POLY_AVX2
+static
+void poly_mul_const_avx2(int32_t *coeffs, int32_t c, int freeze){
+
+    const __m256i w = _mm256_set1_epi32(c);
+    __m256i a;
+
+    for(size_t i = 0; i < N; i += 8){
+        a = _mm256_loadu_si256((const __m256i*)(coeffs + i));
+        a = montgomery_mul_avx2(a, w);
+        if(freeze){
+            a = barrett_avx2(barrett_avx2(a));
+        }
+        _mm256_storeu_si256((__m256i*)(coeffs + i), a);
+    }
+
+}
+
+TARGET_POLY_AVX2
+static
+void poly_iNTT_avx2(poly *src){
+
+    int32_t *coeffs = src->coeffs;
+    const int32_t *twiddle_table = GS_iNTT_twiddle_Rmod_table;
+    __m256i x, y, a, b, w;
+
+    for(size_t i = 0; i < N; i += 16){
+        x = _mm256_loadu_si256((const __m256i*)(coeffs + i));
+        y = _mm256_loadu_si256((const __m256i*)(coeffs + i + 8));
+
+        // level 8, step 1
+        w = twiddle_level8_avx2(twiddle_table, i);
+        a = _mm256_blend_epi32(x, _mm256_slli_epi64(y, 32), 0xAA);
+        b = _mm256_blend_epi32(_mm256_srli_epi64(x, 32), y, 0xAA);
+        GS_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_blend_epi32(a, _mm256_slli_epi64(b, 32), 0xAA);
+        y = _mm256_blend_epi32(_mm256_srli_epi64(a, 32), b, 0xAA);
+
+        // level 7, step 2
+        w = twiddle_level7_avx2(twiddle_table, i);
+        a = _mm256_unpacklo_epi64(x, y);
+        b = _mm256_unpackhi_epi64(x, y);
+        GS_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_unpacklo_epi64(a, b);
+        y = _mm256_unpackhi_epi64(a, b);
+
+        // level 6, step 4
+        w = twiddle_level6_avx2(twiddle_table, i);
+        a = _mm256_permute2x128_si256(x, y, 0x20);
+        b = _mm256_permute2x128_si256(x, y, 0x31);
+        GS_BUTTERFLY_AVX2(a, b, w);
+        x = _mm256_permute2x128_si256(a, b, 0x20);
+        y = _mm256_permute2x128_si256(a, b, 0x31);
+
+        _mm256_storeu_si256((__m256i*)(coeffs + i), x);
+        _mm256_storeu_si256((__m256i*)(coeffs + i + 8), y);
+    }
+
+    NTT_montgomery_core_avx2(coeffs, 5, twiddle_table, 1);
+    poly_mul_const_avx2(coeffs, RmodQ, 0);
+    for(size_t level = 4; level >= 1; level--){
+        NTT_montgomery_core_avx2(coeffs, level, twiddle_table, 1);
+    }
+    poly_mul_const_avx2(coeffs, RmodQ, 0);
+    NTT_montgomery_core_avx2(coeffs, 0, twiddle_table, 1);
+    poly_mul_const_avx2(coeffs, MontgomeryNTTFinalFactor, 1);
+
+}
+
+TARGET_POLY_AVX2
+static
+void poly_point_mul_avx2(poly *des, const poly *src1, const poly *src2){
+
+    __m256i a, b;
+
+    for(size_t i = 0; i < N; i += 8){
+        a = _mm256_loadu_si256((const __m256i*)(src1->coeffs + i));
+        b = _mm256_loadu_si256((const __m256i*)(src2->coeffs + i));
+        _mm256_storeu_si256((__m256i*)(des->coeffs + i), montgomery_mul_avx2(a, b));
+    }
+
+}
+
+#endif
+
+#if GANDALF_POLY_NEON
+
+// montgomery_generic((int64_t)a * b) on 4 lanes. The doubling high
+// products differ by exactly twice the result, since a * b and lo * Q
+// agree modulo 2^32; vhsubq_s32 halves the difference.
+static inline
+int32x4_t montgomery_mul_neon(int32x4_t a, int32x4_t b){
+
+    int32x4_t lo;
+
+    lo = vmulq_s32(vmulq_s32(a, b), vdupq_n_s32(MontgomeryFactor));
+
+    return vhsubq_s32(vqdmulhq_s32(a, b), vqdmulhq_s32(lo, vdupq_n_s32(Q)));
+
+}
+
+// barrett_generic on 4 lanes.
+static inline
+int32x4_t barrett_neon(int32x4_t a){
+
+    const int32x2_t factor = vdup_n_s32(BarrettFactor);
+    const int64x2_t round = vdupq_n_s64(1LL << 31);
+    int32x2_t hl, hh;
+
+    hl = vshrn_n_s64(vaddq_s64(vmull_s32(vget_low_s32(a), factor), round), 32);
+    hh = vshrn_n_s64(vaddq_s64(vmull_s32(vget_high_s32(a), factor), round), 32);
+
+    return vmlsq_s32(a, vcombine_s32(hl, hh), vdupq_n_s32(Q));
+
+}
+
+#define CT_BUTTERFLY_NEON(a, b, w) do { \
+        int32x4_t t_ = montgomery_mul_neon((b), (w)); \
+        (b) = vsubq_s32((a), t_); \
+        (a) = vaddq_s32((a), t_); \
+    } while(0)
+
+#define GS_BUTTERFLY_NEON(a, b, w) do { \
+        int32x4_t t_ = vsubq_s32((a), (b)); \
+        (a) = vaddq_s32((a), (b)); \
+        (b) = montgomery_mul_neon(t_, (w)); \
+    } while(0)
+
+// Twiddles of levels 7 and 8 for the 8 coefficients at offset i.
+static inline
+int32x4_t twiddle_level7_neon(const int32_t *twiddle_table, size_t i){
+    const int32_t *root_ptr = twiddle_table + 127 + i / 4;
+    return vcombine_s32(vdup_n_s32(root_ptr[0]), vdup_n_s32(root_ptr[1]));
+}
+
+static inline
+int32x4_t twiddle_level8_neon(const int32_t *twiddle_table, size_t i){
+    int32x2x2_t w = vld2_s32(twiddle_table + 255 + i / 2);
+    return vcombine_s32(w.val[0], w.val[1]);
+}
+
+#define PAIRS_STEP2_NEON(a, b, x, y) do { \
+        (a) = vreinterpretq_s32_s64(vtrn1q_s64(vreinterpretq_s64_s32(x), vreinterpretq_s64_s32(y))); \
+        (b) = vreinterpretq_s32_s64(vtrn2q_s64(vreinterpretq_s64_s32(x), vreinterpretq_s64_s32(y))); \
+    } while(0)
+
+static
+void NTT_montgomery_core_neon(int32_t *coeffs, size_t level, const int32_t *twiddle_table, int inverse){
+
+    size_t step;
+    const int32_t *root_ptr;
+    int32x4_t a, b, w;
+
+    step = N >> (level + 1);
+    root_ptr = twiddle_table + ((1u << level) - 1);
+
+    for(size_t i = 0; i < N; i += 2 * step){
+        w = vdupq_n_s32(*root_ptr);
+        for(size_t j = i; j < i + step; j += 4){
+            a = vld1q_s32(coeffs + j);
+            b = vld1q_s32(coeffs + j + step);
+            if(inverse){
+                GS_BUTTERFLY_NEON(a, b, w);
+            }else{
+                CT_BUTTERFLY_NEON(a, b, w);
+            }
+            vst1q_s32(coeffs + j, a);
+            vst1q_s32(coeffs + j + step, b);
+        }
+        root_ptr += 1;
+    }
+
+}
+
+static
+void poly_NTT_neon(poly *src){
+
+    int32_t *coeffs = src->coeffs;
+    const int32_t *twiddle_table = CT_NTT_twiddle_Rmod_table;
+    int32x4_t x, y, a, b, w;
+
+    for(size_t level = 0; level < 7; level++){
+        NTT_montgomery_core_neon(coeffs, level, twiddle_table, 0);
+    }
+
+    for(size_t i = 0; i < N; i += 8){
+        x = vld1q_s32(coeffs + i);
+        y = vld1q_s32(coeffs + i + 4);
+
+        // level 7, step 2
+        w = twiddle_level7_neon(twiddle_table, i);
+        PAIRS_STEP2_NEON(a, b, x, y);
+        CT_BUTTERFLY_NEON(a, b, w);
+        PAIRS_STEP2_NEON(x, y, a, b);
+
+        // level 8, step 1
+        w = twiddle_level8_neon(twiddle_table, i);
+        a = vtrn1q_s32(x, y);
+        b = vtrn2q_s32(x, y);
+        CT_BUTTERFLY_NEON(a, b, w);
+        x = vtrn1q_s32(a, b);
+        y = vtrn2q_s32(a, b);
+
+        vst1q_s32(coeffs + i, x);
+        vst1q_s32(coeffs + i + 4, y);
+    }
+
+}
+
+static
+void poly_mul_const_neon(int32_t *coeffs, int32_t c, int freeze){
+
+    const int32x4_t w = vdupq_n_s32(c);
+    int32x4_t a;
+
+    for(size_t i = 0; i < N; i += 4){
+        a = montgomery_mul_neon(vld1q_s32(coeffs + i), w);
+        if(freeze){
+            a = barrett_neon(barrett_neon(a));
+        }
+        vst1q_s32(coeffs + i, a);
+    }
+
+}
+
+static
+void poly_iNTT_neon(poly *src){
+
+    int32_t *coeffs = src->coeffs;
+    const int32_t *twiddle_table = GS_iNTT_twiddle_Rmod_table;
+    int32x4_t x, y, a, b, w;
+
+    for(size_t i = 0; i < N; i += 8){
+        x = vld1q_s32(coeffs + i);
+        y = vld1q_s32(coeffs + i + 4);
+
+        // level 8, step 1
+        w = twiddle_level8_neon(twiddle_table, i);
+        a = vtrn1q_s32(x, y);
+        b = vtrn2q_s32(x, y);
+        GS_BUTTERFLY_NEON(a, b, w);
+        x = vtrn1q_s32(a, b);
+        y = vtrn2q_s32(a, b);
+
+        // level 7, step 2
+        w = twiddle_level7_neon(twiddle_table, i);
+        PAIRS_STEP2_NEON(a, b, x, y);
+        GS_BUTTERFLY_NEON(a, b, w);
+        PAIRS_STEP2_NEON(x, y, a, b);
+
+        vst1q_s32(coeffs + i, x);
+        vst1q_s32(coeffs + i + 4, y);
+    }
+
+    for(size_t level = 6; level >= 5; level--){
+        NTT_montgomery_core_neon(coeffs, level, twiddle_table, 1);
+    }
+    poly_mul_const_neon(coeffs, RmodQ, 0);
+    for(size_t level = 4; level >= 1; level--){
+        NTT_montgomery_core_neon(coeffs, level, twiddle_table, 1);
+    }
+    poly_mul_const_neon(coeffs, RmodQ, 0);
+    NTT_montgomery_core_neon(coeffs, 0, twiddle_table, 1);
+    poly_mul_const_neon(coeffs, MontgomeryNTTFinalFactor, 1);
+
+}
+
+static
+void poly_point_mul_neon(poly *des, const poly *src1, const poly *src2){
+    for(size_t i = 0; i < N; i += 4){
+        vst1q_s32(des->coeffs + i, montgomery_mul_neon(vld1q_s32(src1->coeffs + i), vld1q_s32(src2->coeffs + i)));
+    }
+}
+
+#endif
+
+// ================
+// dispatch
+
+// The AVX2 check is made once at load time instead of on every transform.
+#if GANDALF_POLY_AVX2
+static int poly_use_avx2;
+
+__attribute__((constructor))
+static void poly_simd_init(void){
+    __builtin_cpu_init();
+    poly_use_avx2 = __builtin_cpu_supports("avx2");
+}
+#endif
+
+void poly_NTT(poly *src){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+#if GANDALF_POLY_AVX2
+    if(poly_use_avx2){
+        poly_NTT_avx2(src);
+        return;
+    }
+#elif GANDALF_POLY_NEON
+    poly_NTT_neon(src);
+    return;
+#endif
+    poly_NTT_montgomery_generic(src, CT_NTT_twiddle_Rmod_table, data);
+}
+
+void poly_iNTT(poly *src){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+#if GANDALF_POLY_AVX2
+    if(poly_use_avx2){
+        poly_iNTT_avx2(src);
+        return;
+    }
+#elif GANDALF_POLY_NEON
+    poly_iNTT_neon(src);
+    return;
+#endif
+    poly_iNTT_montgomery_generic(src, GS_iNTT_twiddle_Rmod_table, data);
+}
+
+void poly_point_mul(poly *des, const poly *src1, const poly *src2){
+    const ZArithData data = {Q, BarrettFactor, NTTFinalFactor, RmodQ, R2modQ, MontgomeryFactor, MontgomeryNTTFinalFactor};
+#if GANDALF_POLY_AVX2
+    if(poly_use_avx2){
+        poly_point_mul_avx2(des, src1, src2);
+        return;
+    }
+#elif GANDALF_POLY_NEON
+    poly_point_mul_neon(des, src1, src2);
+    return;
+#endif
+    poly_point_mul_generic(des, src1, src2, data);
+}
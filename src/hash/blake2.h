@@ -4,7 +4,18 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/*
+ * Define BLAKE2_AVX2 to 0 in order to disable the AVX2 engine (used by
+ * blake2s_expand() for pairs of blocks). It is gated at runtime on CPU
+ * support.
+ */
+#ifndef BLAKE2_AVX2
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define BLAKE2_AVX2        1
+#else
 #define BLAKE2_AVX2        0
+#endif
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +54,16 @@ void blake2s(void *dst, size_t dst_len, const void *key, size_t key_len,
 void blake2s_expand(void *dst, size_t dst_len,
 	const void *seed, size_t seed_len, uint64_t label);
 
+/*
+ * blake2s() and blake2s_expand() on the portable engine, whatever the CPU
+ * supports; for testing the AVX2 engine against.
+ */
+void blake2s_ref(void *dst, size_t dst_len, const void *key, size_t key_len,
+	const void *src, size_t src_len);
+
+void blake2s_expand_ref(void *dst, size_t dst_len,
+	const void *seed, size_t seed_len, uint64_t label);
+
 typedef struct {
 	uint8_t buf[128];
 	uint64_t h[8];
@@ -9,6 +9,23 @@
 
 #include "blake2.h"
 
+#if BLAKE2_AVX2
+#include <immintrin.h>
+#define TARGET_AVX2    __attribute__((target("avx2")))
+#define ALIGNED_AVX2   __attribute__((aligned(32)))
+
+static inline void
+enc32le(void *dst, uint32_t x)
+{
+	uint8_t *buf = dst;
+
+	buf[0] = (uint8_t)x;
+	buf[1] = (uint8_t)(x >> 8);
+	buf[2] = (uint8_t)(x >> 16);
+	buf[3] = (uint8_t)(x >> 24);
+}
+#endif
+
 static const uint32_t IV[] = {
 	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
 	0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
@@ -18,7 +35,7 @@ static const uint32_t IV[] = {
 
 TARGET_AVX2
 static void
-process_block(uint32_t *h, const uint8_t *data, uint64_t t, int f)
+process_block_avx2(uint32_t *h, const uint8_t *data, uint64_t t, int f)
 {
 	__m128i xh0, xh1, xv0, xv1, xv2, xv3;
 	__m128i xm0, xm1, xm2, xm3, xn0, xn1, xn2, xn3;
@@ -667,10 +684,10 @@ expand_inner_x2(uint8_t *dst, size_t dst_len,
 	}
 }
 
-#else
+#endif
 
 static void
-process_block(uint32_t *h, const uint8_t *data, uint64_t t, int f)
+process_block_portable(uint32_t *h, const uint8_t *data, uint64_t t, int f)
 {
 	uint32_t v[16], m[16];
 	int i;
@@ -731,8 +748,40 @@ process_block(uint32_t *h, const uint8_t *data, uint64_t t, int f)
 	}
 }
 
+/*
+ * The AVX2 engine is selected at runtime (CPU support is looked up once,
+ * when the library is loaded); both engines compute the same function.
+ * The *_ref entry points always use the portable engine.
+ */
+#if BLAKE2_AVX2
+static int blake2_use_avx2;
+
+__attribute__((constructor))
+static void
+blake2_avx2_init(void)
+{
+	__builtin_cpu_init();
+	blake2_use_avx2 = __builtin_cpu_supports("avx2");
+}
+#else
+#define blake2_use_avx2   0
 #endif
 
+static void
+process_block(uint32_t *h, const uint8_t *data, uint64_t t, int f,
+	int use_avx2)
+{
+#if BLAKE2_AVX2
+	if (use_avx2) {
+		process_block_avx2(h, data, t, f);
+		return;
+	}
+#else
+	(void)use_avx2;
+#endif
+	process_block_portable(h, data, t, f);
+}
+
 /*
  * State rules:
  *
@@ -772,9 +821,9 @@ blake2s_init_key(blake2s_context *bc, size_t out_len,
 	}
 }
 
-/* see blake2.h */
-void
-blake2s_update(blake2s_context *bc, const void *data, size_t len)
+static void
+blake2s_update_inner(blake2s_context *bc, const void *data, size_t len,
+	int use_avx2)
 {
 	uint64_t ctr;
 	size_t p;
@@ -805,12 +854,12 @@ blake2s_update(blake2s_context *bc, const void *data, size_t len)
 	}
 
 	/* Process the buffered block. */
-	process_block(bc->h, bc->buf, ctr, 0);
+	process_block(bc->h, bc->buf, ctr, 0, use_avx2);
 
 	/* Process all subsequent full blocks, except the last. */
 	while (len > sizeof bc->buf) {
 		ctr += sizeof bc->buf;
-		process_block(bc->h, data, ctr, 0);
+		process_block(bc->h, data, ctr, 0, use_avx2);
 		data = (const uint8_t *)data + sizeof bc->buf;
 		len -= sizeof bc->buf;
 	}
@@ -820,9 +869,8 @@ blake2s_update(blake2s_context *bc, const void *data, size_t len)
 	bc->ctr = ctr + len;
 }
 
-/* see blake2.h */
-void
-blake2s_final(blake2s_context *bc, void *dst)
+static void
+blake2s_final_inner(blake2s_context *bc, void *dst, int use_avx2)
 {
 	size_t p;
 
@@ -834,11 +882,25 @@ blake2s_final(blake2s_context *bc, void *dst)
 		memset(bc->buf + p, 0, (sizeof bc->buf) - p);
 	}
 
-	process_block(bc->h, bc->buf, bc->ctr, 1);
+	process_block(bc->h, bc->buf, bc->ctr, 1, use_avx2);
 	memcpy(dst, bc->h, bc->out_len);
 
 }
 
+/* see blake2.h */
+void
+blake2s_update(blake2s_context *bc, const void *data, size_t len)
+{
+	blake2s_update_inner(bc, data, len, blake2_use_avx2);
+}
+
+/* see blake2.h */
+void
+blake2s_final(blake2s_context *bc, void *dst)
+{
+	blake2s_final_inner(bc, dst, blake2_use_avx2);
+}
+
 /* see blake2.h */
 void
 blake2s(void *dst, size_t dst_len, const void *key, size_t key_len,
@@ -853,8 +915,19 @@ blake2s(void *dst, size_t dst_len, const void *key, size_t key_len,
 
 /* see blake2.h */
 void
-blake2s_expand(void *dst, size_t dst_len,
-	const void *seed, size_t seed_len, uint64_t label)
+blake2s_ref(void *dst, size_t dst_len, const void *key, size_t key_len,
+	const void *src, size_t src_len)
+{
+	blake2s_context bc;
+
+	blake2s_init_key(&bc, dst_len, key, key_len);
+	blake2s_update_inner(&bc, src, src_len, 0);
+	blake2s_final_inner(&bc, dst, 0);
+}
+
+static void
+blake2s_expand_inner(void *dst, size_t dst_len,
+	const void *seed, size_t seed_len, uint64_t label, int use_avx2)
 {
 	uint32_t h[8];
 	uint8_t buf[64];
@@ -868,7 +941,7 @@ blake2s_expand(void *dst, size_t dst_len,
 	memset(buf + in_len, 0, (sizeof buf) - in_len);
 	num = 0;
 #if BLAKE2_AVX2
-	if (dst_len >= 64) {
+	if (dst_len >= 64 && use_avx2) {
 		uint8_t buf_x2[128];
 
 		memcpy(buf_x2 +   0, buf +  0, 16);
@@ -908,7 +981,7 @@ blake2s_expand(void *dst, size_t dst_len,
 		memcpy(h, IV, sizeof h);
 		h[0] ^= 0x01010000 ^ (sizeof h);
 		memcpy(buf + 8, &num, 8); num++;
-		process_block(h, buf, in_len, 1);
+		process_block(h, buf, in_len, 1, use_avx2);
 		clen = dst_len < (sizeof h) ? dst_len : (sizeof h);
 		memcpy(dst, h, clen);
 
@@ -916,3 +989,20 @@ blake2s_expand(void *dst, size_t dst_len,
 		dst = (uint8_t *)dst + clen;
 	}
 }
+
+/* see blake2.h */
+void
+blake2s_expand(void *dst, size_t dst_len,
+	const void *seed, size_t seed_len, uint64_t label)
+{
+	blake2s_expand_inner(dst, dst_len, seed, seed_len, label,
+		blake2_use_avx2);
+}
+
+/* see blake2.h */
+void
+blake2s_expand_ref(void *dst, size_t dst_len,
+	const void *seed, size_t seed_len, uint64_t label)
+{
+	blake2s_expand_inner(dst, dst_len, seed, seed_len, label, 0);
+}
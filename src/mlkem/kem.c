@@ -140,6 +140,43 @@ int crypto_kem_enc(uint8_t *ct,
 int crypto_kem_dec(uint8_t *ss,
                    const uint8_t *ct,
                    const uint8_t *sk)
+{
+  polyvec skpv, pkpv, at[KYBER_K];
+
+  indcpa_expand_sk(&skpv, sk);
+  indcpa_expand_pk(&pkpv, at, sk+KYBER_INDCPA_SECRETKEYBYTES);
+
+  return crypto_kem_dec_expanded(ss, ct, sk, &skpv, &pkpv, at);
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_expanded
+*
+* Description: crypto_kem_dec with the secret key and the public key
+*              stored in it already expanded by indcpa_expand_sk and
+*              indcpa_expand_pk, so that decapsulating many ciphertexts
+*              under one key samples the matrix A only once.
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*              - const polyvec *skpv: expanded indcpa secret key of sk
+*              - const polyvec *pkpv: expanded indcpa public key of sk
+*              - const polyvec *at: matrix A^T of the public key of sk
+*
+* Returns 0.
+*
+* On failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_expanded(uint8_t *ss,
+                            const uint8_t *ct,
+                            const uint8_t *sk,
+                            const polyvec *skpv,
+                            const polyvec *pkpv,
+                            const polyvec at[KYBER_K])
 {
   int fail;
   uint8_t buf[2*KYBER_SYMBYTES];
@@ -147,16 +184,15 @@ int crypto_kem_dec(uint8_t *ss,
   uint8_t kr[2*KYBER_SYMBYTES];
 //  uint8_t cmp[KYBER_CIPHERTEXTBYTES+KYBER_SYMBYTES];
   uint8_t cmp[KYBER_CIPHERTEXTBYTES];
-  const uint8_t *pk = sk+KYBER_INDCPA_SECRETKEYBYTES;
 
-  indcpa_dec(buf, ct, sk);
+  indcpa_dec_expanded(buf, ct, skpv);
 
   /* Multitarget countermeasure for coins + contributory KEM */
   memcpy(buf+KYBER_SYMBYTES, sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
   hash_g(kr, buf, 2*KYBER_SYMBYTES);
 
   /* coins are in kr+KYBER_SYMBYTES */
-  indcpa_enc(cmp, buf, pk, kr+KYBER_SYMBYTES);
+  indcpa_enc_expanded(cmp, buf, pkpv, at, kr+KYBER_SYMBYTES);
 
   fail = verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
 
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "params.h"
+#include "polyvec.h"
 
 #define CRYPTO_SECRETKEYBYTES  KYBER_SECRETKEYBYTES
 #define CRYPTO_PUBLICKEYBYTES  KYBER_PUBLICKEYBYTES
@@ -32,4 +33,8 @@ int crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
 #define crypto_kem_dec KYBER_NAMESPACE(dec)
 int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
 
+#define crypto_kem_dec_expanded KYBER_NAMESPACE(dec_expanded)
+int crypto_kem_dec_expanded(uint8_t *ss, const uint8_t *ct, const uint8_t *sk,
+                            const polyvec *skpv, const polyvec *pkpv, const polyvec at[KYBER_K]);
+
 #endif
@@ -2,6 +2,7 @@
 #include "kem_api.h"
 #include "kem.h"
 #include "fips202.h"
+#include "indcpa.h"
 
 int kem_keygen(kem_sk *sk, kem_pk *pk) {
     crypto_kem_keypair(pk->pk, sk->sk);
@@ -17,6 +18,17 @@ int kem_encap(
     return 1;
 }
 
+int kem_encap_ctx(
+    void *secret, size_t secret_len, kem_ct *ct,
+    const kem_pk *pk, prng *ctx) {
+    uint8_t key[CRYPTO_BYTES];
+    uint8_t coins[KYBER_SYMBYTES];
+    randombytes_ctx(ctx, coins, KYBER_SYMBYTES);
+    crypto_kem_enc_derand(ct->ct, key, pk->pk, coins);
+    shake256(secret, secret_len, key, CRYPTO_BYTES);
+    return 1;
+}
+
 int kem_decap(
     void *secret, size_t secret_len, const kem_ct *ct,
     const kem_sk *sk) {
@@ -29,3 +41,31 @@ int kem_decap(
     // crypto_kem_dec(secret, secret_len, ct->ct, sk->sk);
     return 1;
 }
+
+void kem_prepare_sk(kem_sk_prepared *prepared, const kem_sk *sk) {
+    prepared->sk = *sk;
+    indcpa_expand_sk((polyvec*)prepared->skpv, sk->sk);
+    indcpa_expand_pk((polyvec*)prepared->pkpv, (polyvec*)prepared->at,
+                     sk->sk + KYBER_INDCPA_SECRETKEYBYTES);
+}
+
+int kem_decap_prepared(
+    void *secret, size_t secret_len, const kem_ct *ct,
+    const kem_sk_prepared *sk) {
+
+    uint8_t key[CRYPTO_BYTES];
+
+    crypto_kem_dec_expanded(key, ct->ct, sk->sk.sk,
+                            (const polyvec*)sk->skpv, (const polyvec*)sk->pkpv,
+                            (const polyvec*)sk->at);
+    shake256(secret, secret_len, key, CRYPTO_BYTES);
+
+    return 1;
+}
+
+void kem_sk_prepared_release(kem_sk_prepared *prepared) {
+    volatile uint8_t *p = (volatile uint8_t*)prepared;
+    for(size_t i = 0; i < sizeof(kem_sk_prepared); i++){
+        p[i] = 0;
+    }
+}
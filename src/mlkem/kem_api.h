@@ -5,6 +5,7 @@
 #include <stddef.h>
 
 #include "params.h"
+#include "randombytes.h"
 
 #define KEM_PUBLICKEY_BYTES KYBER_PUBLICKEYBYTES
 #define KEM_CIPHERTXT_BYTES KYBER_CIPHERTEXTBYTES
@@ -22,14 +23,35 @@ typedef struct {
     uint8_t ct[KEM_CIPHERTXT_BYTES];
 } kem_ct;
 
+// kem_sk with its secret vector unpacked and the matrix of its public
+// key expanded, for decapsulating many ciphertexts under one key.
+// The polynomial vectors are stored as plain arrays so that this header
+// does not pull in the ML-KEM poly type.
+typedef struct {
+    kem_sk sk;
+    int16_t skpv[KYBER_K][KYBER_N];
+    int16_t pkpv[KYBER_K][KYBER_N];
+    int16_t at[KYBER_K][KYBER_K][KYBER_N];
+} kem_sk_prepared;
+
 int kem_keygen(kem_sk *sk, kem_pk *pk);
 int kem_encap(
     void *secret, size_t secret_len, kem_ct *ct,
     const kem_pk *pk);
+// kem_encap with its coins drawn from ctx instead of the current context.
+int kem_encap_ctx(
+    void *secret, size_t secret_len, kem_ct *ct,
+    const kem_pk *pk, prng *ctx);
 int kem_decap(
     void *secret, size_t secret_len, const kem_ct *ct,
     const kem_sk *sk);
 
+void kem_prepare_sk(kem_sk_prepared *prepared, const kem_sk *sk);
+int kem_decap_prepared(
+    void *secret, size_t secret_len, const kem_ct *ct,
+    const kem_sk_prepared *sk);
+void kem_sk_prepared_release(kem_sk_prepared *prepared);
+
 #endif
 
 
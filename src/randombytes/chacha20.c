@@ -0,0 +1,203 @@
+
+#include "chacha20.h"
+
+#include <string.h>
+
+/* Define CHACHA20_AVX2 to 0 in order to disable the AVX2 engine.
+   The engine is gated at runtime on CPU support. */
+#ifndef CHACHA20_AVX2
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define CHACHA20_AVX2   1
+#else
+#define CHACHA20_AVX2   0
+#endif
+#endif
+
+#if CHACHA20_AVX2
+#include <immintrin.h>
+#define TARGET_CHACHA20_AVX2   __attribute__((target("avx2")))
+#endif
+
+static inline uint32_t
+dec32le(const uint8_t *src)
+{
+    return (uint32_t)src[0]
+        | ((uint32_t)src[1] << 8)
+        | ((uint32_t)src[2] << 16)
+        | ((uint32_t)src[3] << 24);
+}
+
+static inline void
+enc32le(uint8_t *dst, uint32_t x)
+{
+    dst[0] = (uint8_t)x;
+    dst[1] = (uint8_t)(x >> 8);
+    dst[2] = (uint8_t)(x >> 16);
+    dst[3] = (uint8_t)(x >> 24);
+}
+
+// "expand 32-byte k", the key, the counter and the nonce.
+static void
+chacha20_init(uint32_t *s, const uint8_t *key, const uint8_t *nonce, uint32_t ctr)
+{
+    s[0] = 0x61707865;
+    s[1] = 0x3320646e;
+    s[2] = 0x79622d32;
+    s[3] = 0x6b206574;
+    for(size_t i = 0; i < 8; i++){
+        s[4 + i] = dec32le(key + 4 * i);
+    }
+    s[12] = ctr;
+    for(size_t i = 0; i < 3; i++){
+        s[13 + i] = dec32le(nonce + 4 * i);
+    }
+}
+
+#define ROTL32(x, n)   (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QROUND(a, b, c, d) { \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d,  8); \
+    c += d; b ^= c; b = ROTL32(b,  7); \
+}
+
+void
+chacha20_blocks_ref(uint8_t *dst, size_t nblocks,
+    const uint8_t *key, const uint8_t *nonce, uint32_t ctr)
+{
+    uint32_t s[16], x[16];
+
+    chacha20_init(s, key, nonce, ctr);
+    for(size_t j = 0; j < nblocks; j++){
+        memcpy(x, s, sizeof x);
+        for(size_t r = 0; r < 10; r++){
+            QROUND(x[0], x[4], x[ 8], x[12]);
+            QROUND(x[1], x[5], x[ 9], x[13]);
+            QROUND(x[2], x[6], x[10], x[14]);
+            QROUND(x[3], x[7], x[11], x[15]);
+            QROUND(x[0], x[5], x[10], x[15]);
+            QROUND(x[1], x[6], x[11], x[12]);
+            QROUND(x[2], x[7], x[ 8], x[13]);
+            QROUND(x[3], x[4], x[ 9], x[14]);
+        }
+        for(size_t i = 0; i < 16; i++){
+            enc32le(dst + 4 * i, x[i] + s[i]);
+        }
+        dst += 64;
+        s[12]++;
+    }
+}
+
+#if CHACHA20_AVX2
+
+// Eight blocks side by side: vector i holds word i of the eight blocks,
+// whose counters are ctr, ..., ctr + 7. The final 8x8 transposes turn the
+// words back into consecutive blocks.
+#define ROTL32_AVX2(x, n)   _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+
+#define QROUND_AVX2(a, b, c, d) { \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL32_AVX2(b, 12); \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL32_AVX2(b, 7); \
+}
+
+// Writes the words 0..7 (or 8..15) of eight blocks from the vectors r[0..7].
+TARGET_CHACHA20_AVX2
+static void
+transpose_store_avx2(uint8_t *dst, const __m256i *r)
+{
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m256i u0, u1, u2, u3, u4, u5, u6, u7;
+
+    t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    u0 = _mm256_unpacklo_epi64(t0, t2);
+    u1 = _mm256_unpackhi_epi64(t0, t2);
+    u2 = _mm256_unpacklo_epi64(t1, t3);
+    u3 = _mm256_unpackhi_epi64(t1, t3);
+    u4 = _mm256_unpacklo_epi64(t4, t6);
+    u5 = _mm256_unpackhi_epi64(t4, t6);
+    u6 = _mm256_unpacklo_epi64(t5, t7);
+    u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    _mm256_storeu_si256((__m256i *)(dst + 0 * 64), _mm256_permute2x128_si256(u0, u4, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 1 * 64), _mm256_permute2x128_si256(u1, u5, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 2 * 64), _mm256_permute2x128_si256(u2, u6, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 3 * 64), _mm256_permute2x128_si256(u3, u7, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 4 * 64), _mm256_permute2x128_si256(u0, u4, 0x31));
+    _mm256_storeu_si256((__m256i *)(dst + 5 * 64), _mm256_permute2x128_si256(u1, u5, 0x31));
+    _mm256_storeu_si256((__m256i *)(dst + 6 * 64), _mm256_permute2x128_si256(u2, u6, 0x31));
+    _mm256_storeu_si256((__m256i *)(dst + 7 * 64), _mm256_permute2x128_si256(u3, u7, 0x31));
+}
+
+TARGET_CHACHA20_AVX2
+static void
+chacha20_blocks_x8_avx2(uint8_t *dst, size_t nblocks, uint32_t *s)
+{
+    const __m256i rot16 = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256i v[16], x[16];
+
+    for(size_t i = 0; i < 16; i++){
+        v[i] = _mm256_set1_epi32((int32_t)s[i]);
+    }
+    v[12] = _mm256_add_epi32(v[12], lanes);
+
+    for(size_t j = 0; j < nblocks; j += 8){
+        for(size_t i = 0; i < 16; i++){
+            x[i] = v[i];
+        }
+        for(size_t r = 0; r < 10; r++){
+            QROUND_AVX2(x[0], x[4], x[ 8], x[12]);
+            QROUND_AVX2(x[1], x[5], x[ 9], x[13]);
+            QROUND_AVX2(x[2], x[6], x[10], x[14]);
+            QROUND_AVX2(x[3], x[7], x[11], x[15]);
+            QROUND_AVX2(x[0], x[5], x[10], x[15]);
+            QROUND_AVX2(x[1], x[6], x[11], x[12]);
+            QROUND_AVX2(x[2], x[7], x[ 8], x[13]);
+            QROUND_AVX2(x[3], x[4], x[ 9], x[14]);
+        }
+        for(size_t i = 0; i < 16; i++){
+            x[i] = _mm256_add_epi32(x[i], v[i]);
+        }
+        transpose_store_avx2(dst + 8 * 64 * (j / 8), x);
+        transpose_store_avx2(dst + 8 * 64 * (j / 8) + 32, x + 8);
+        v[12] = _mm256_add_epi32(v[12], _mm256_set1_epi32(8));
+    }
+}
+
+#endif
+
+void
+chacha20_blocks(uint8_t *dst, size_t nblocks,
+    const uint8_t *key, const uint8_t *nonce, uint32_t ctr)
+{
+#if CHACHA20_AVX2
+    if(nblocks >= 8 && __builtin_cpu_supports("avx2")){
+        uint32_t s[16];
+        size_t n8 = nblocks & ~(size_t)7;
+
+        chacha20_init(s, key, nonce, ctr);
+        chacha20_blocks_x8_avx2(dst, n8, s);
+        dst += 64 * n8;
+        nblocks -= n8;
+        ctr += (uint32_t)n8;
+    }
+#endif
+    chacha20_blocks_ref(dst, nblocks, key, nonce, ctr);
+}
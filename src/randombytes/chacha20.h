@@ -0,0 +1,21 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * ChaCha20 keystream (RFC 8439): nblocks blocks of 64 bytes for the 32-byte
+ * key, the 12-byte nonce and the block counters ctr, ctr + 1, ...
+ * The counter is 32 bits; the caller must not let it wrap.
+ *
+ * chacha20_blocks runs eight blocks at a time with AVX2 when the CPU
+ * supports it; chacha20_blocks_ref is the portable one-block-at-a-time
+ * code. Both produce the same output.
+ */
+void chacha20_blocks(uint8_t *dst, size_t nblocks,
+    const uint8_t *key, const uint8_t *nonce, uint32_t ctr);
+void chacha20_blocks_ref(uint8_t *dst, size_t nblocks,
+    const uint8_t *key, const uint8_t *nonce, uint32_t ctr);
+
+#endif
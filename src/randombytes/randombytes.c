@@ -3,7 +3,46 @@
 #include "sys_rand.h"
 #include "randombytes.h"
 
-prng p;
+/* Fork detection is available where fork() is. */
+#ifndef RANDOMBYTES_FORK_SAFE
+#if defined _WIN32 || defined _WIN64
+#define RANDOMBYTES_FORK_SAFE 0
+#else
+#define RANDOMBYTES_FORK_SAFE 1
+#endif
+#endif
+
+#if RANDOMBYTES_FORK_SAFE
+#include <pthread.h>
+#endif
+
+// Each thread draws from its own context: the one installed with
+// set_prng_ctx(), or by default (p_current == NULL) a thread-local context
+// seeded from the system on first use. p_local keeps its state while
+// another context is installed.
+static _Thread_local prng p_local;
+static _Thread_local int p_local_seeded;
+static _Thread_local prng *p_current;
+
+// Incremented in the child after each fork(). A context seeded from the
+// system records it and reseeds as soon as it differs, before handing out
+// any byte, so that parent and children never share buffered or future
+// output.
+static volatile unsigned fork_gen;
+
+#if RANDOMBYTES_FORK_SAFE
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static
+void atfork_child(void){
+    fork_gen++;
+}
+
+static
+void atfork_register(void){
+    pthread_atfork(NULL, NULL, atfork_child);
+}
+#endif
 
 const
 uint8_t _seed[48] = {
@@ -12,28 +51,75 @@ uint8_t _seed[48] = {
     0x9, 0xc, 0x8, 0xb, 0xf, 0xa, 0x1, 0xd, 0x3, 0x4, 0x7, 0x6, 0xe, 0x5, 0x0, 0x2
 };
 
+static
+prng *check_prng_ctx(prng *ctx){
+    if(ctx->autoseed && (ctx->fork_gen != fork_gen || ctx->out_bytes >= PRNG_RESEED_BYTES)){
+        seed_prng_ctx(ctx);
+    }
+    return ctx;
+}
+
+static
+prng *get_prng_ctx(void){
+    prng *ctx = p_current;
+
+    if(ctx == NULL){
+        if(!p_local_seeded){
+            seed_prng_ctx(&p_local);
+            p_local_seeded = 1;
+        }
+        ctx = &p_local;
+    }
+    return check_prng_ctx(ctx);
+}
+
 int randombytes(uint8_t *buf, size_t n){
-    return prng_get_bytes(&p, buf, (int)n);
+    return prng_get_bytes(get_prng_ctx(), buf, (int)n);
+}
+
+int randombytes_ctx(prng *ctx, uint8_t *buf, size_t n){
+    return prng_get_bytes(check_prng_ctx(ctx), buf, (int)n);
 }
 
 uint64_t get64(){
-    return prng_get_u64(&p);
+    return prng_get_u64(get_prng_ctx());
+}
+
+void get64_bulk(uint64_t *dst, size_t n){
+    prng_get_u64_bulk(get_prng_ctx(), dst, n);
 }
 
 uint8_t get8(){
-    return prng_get_u8(&p);
+    return prng_get_u8(get_prng_ctx());
 }
 
-void seed_rng(void){
+void seed_prng_ctx(prng *ctx){
     // must not exceed 48 bytes
     uint8_t seed[48];
 
+#if RANDOMBYTES_FORK_SAFE
+    pthread_once(&atfork_once, atfork_register);
+#endif
+
     get_seed(seed, sizeof seed);
 
-    prng_init(&p, seed, sizeof seed, 0);
+    prng_init(ctx, seed, sizeof seed, 0);
+    ctx->autoseed = 1;
+    ctx->fork_gen = fork_gen;
+}
+
+prng *set_prng_ctx(prng *ctx){
+    prng *old = p_current;
+
+    p_current = ctx;
+    return old;
+}
+
+void seed_rng(void){
+    seed_prng_ctx(get_prng_ctx());
 }
 
 void init_prng(void){
-    prng_init(&p, _seed, sizeof _seed, 0);
+    prng_init(get_prng_ctx(), _seed, sizeof _seed, 0);
 }
 
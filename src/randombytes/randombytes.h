@@ -1,15 +1,45 @@
 #ifndef RANDOMBYTES_H
 #define RANDOMBYTES_H
 
+#include "rng.h"
+
 #include <stdint.h>
 #include <stddef.h>
 
+// All functions below act on the calling thread's PRNG context, so that
+// threads never share state. By default it is a thread-local context seeded
+// from the system on first use; a thread may install its own with
+// set_prng_ctx(). Every API drawing randomness (sign_keygen, Gandalf_sign,
+// kem_encap, nike_keygen, the AKEMs, ...) uses the current context;
+// sign_keygen_ctx, Gandalf_sign_ctx, kem_encap_ctx and nike_keygen_ctx take
+// an explicit context instead.
+//
+// Contexts seeded from the system (the default one, seed_rng() and
+// seed_prng_ctx()) are reseeded from the system after each fork() and
+// every PRNG_RESEED_BYTES of output. Contexts seeded with init_prng() or
+// prng_init() are deterministic and never reseeded.
+
+// (Re)seeds the current context from the system.
 void seed_rng(void);
 
 int randombytes(uint8_t *buf, size_t n);
 uint64_t get64(void);
+// Same values as n successive calls to get64().
+void get64_bulk(uint64_t *dst, size_t n);
 uint8_t get8(void);
+// Seeds the current context with a fixed seed, for reproducible tests.
 void init_prng(void);
 
+// Seeds a caller-owned context from the system.
+void seed_prng_ctx(prng *ctx);
+// randombytes drawing from ctx instead of the current context, with the
+// same reseeding.
+int randombytes_ctx(prng *ctx, uint8_t *buf, size_t n);
+// Makes ctx the calling thread's context and returns the previous one
+// (NULL for the default thread-local context). Passing NULL restores the
+// default, which keeps its state in the meantime. The context must outlive
+// its use and must not be shared between threads.
+prng *set_prng_ctx(prng *ctx);
+
 
 #endif
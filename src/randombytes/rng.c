@@ -30,6 +30,7 @@
  */
 
 #include "rng.h"
+#include "chacha20.h"
 
 #include <memory.h>
 
@@ -43,14 +44,70 @@ prng_init(prng *p, const void *seed, size_t seed_len, uint64_t label)
 	blake2s_expand(p->key.d, sizeof p->key.d, seed, seed_len, label);
     p->ptr = sizeof p->buf;
     p->ctr = 0;
+    p->out_bytes = 0;
+    p->autoseed = 0;
+    p->fork_gen = 0;
+}
+
+/*
+ * Output of the PRNG for one refill counter: len bytes in dst.
+ */
+static void
+prng_expand(const prng *p, void *dst, size_t len, uint64_t label)
+{
+#if PRNG_CHACHA20
+	uint8_t nonce[12], tail[64];
+	size_t nblocks;
+
+	memcpy(nonce, &label, 8);
+	memset(nonce + 8, 0, 4);
+	nblocks = len >> 6;
+	chacha20_blocks(dst, nblocks, p->key.d, nonce, 0);
+	if ((len & 63) != 0) {
+		chacha20_blocks(tail, 1, p->key.d, nonce, (uint32_t)nblocks);
+		memcpy((uint8_t *)dst + (nblocks << 6), tail, len & 63);
+	}
+#else
+	blake2s_expand(dst, len, p->key.d, sizeof p->key.d, label);
+#endif
+}
+
+/* see rng.h */
+void
+prng_refill(prng *p)
+{
+	prng_expand(p, p->buf.d, sizeof p->buf.d, p->ctr++);
+	p->ptr = 0;
+	p->out_bytes += sizeof p->buf.d;
 }
 
 /* see rng.h */
 int
 prng_get_bytes(prng *p, void *dst, size_t len)
 {
-	blake2s_expand(dst, len, p->key.d, sizeof p->key.d, p->ctr++);
+	prng_expand(p, dst, len, p->ctr++);
+	p->out_bytes += len;
 	return (int)len;
 }
 
+/* see rng.h */
+void
+prng_get_u64_bulk(prng *p, uint64_t *dst, size_t n)
+{
+	size_t k;
 
+	while (n > 0) {
+		/* Same refill rule as prng_get_u64(). */
+		if (p->ptr >= (sizeof p->buf) - 9) {
+			prng_refill(p);
+		}
+		k = ((sizeof p->buf) - 10 - p->ptr) / 8 + 1;
+		if (k > n) {
+			k = n;
+		}
+		memcpy(dst, p->buf.d + p->ptr, k * 8);
+		p->ptr += k * 8;
+		dst += k;
+		n -= k;
+	}
+}
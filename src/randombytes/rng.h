@@ -8,11 +8,36 @@
 
 /*
  *
- * A PRNG based on ChaCha20 is implemented; it is seeded from a SHAKE256
- * context (flipped) and is used for bulk pseudorandom generation.
+ * A PRNG based on ChaCha20 is implemented; its key is derived from the
+ * seed with blake2s_expand() and it is used for bulk pseudorandom
+ * generation. Each refill (and each prng_get_bytes() call) is the ChaCha20
+ * keystream for the nonce (ctr, 0) from block counter 0, where ctr counts
+ * the refills. With PRNG_CHACHA20 defined to 0, the refills use
+ * blake2s_expand() with ctr as the label instead.
  * A system-dependent seed generator is also provided.
  */
 
+#ifndef PRNG_CHACHA20
+#define PRNG_CHACHA20 1
+#endif
+
+/*
+ * Size of the PRNG buffer, i.e. the refill block. It must be a multiple of
+ * 64 bytes (two BLAKE2s blocks, as processed by the AVX2 expander, or one
+ * ChaCha20 block; 512 bytes are one pass of the 8-way AVX2 ChaCha20).
+ * Changing it changes the pseudorandom stream.
+ */
+#ifndef PRNG_BUFFER_BYTES
+#define PRNG_BUFFER_BYTES 512
+#endif
+
+/*
+ * Output after which a context seeded from the system is reseeded.
+ */
+#ifndef PRNG_RESEED_BYTES
+#define PRNG_RESEED_BYTES ((uint64_t)1 << 20)
+#endif
+
 /*
  * Structure for a PRNG. This includes a large buffer so that values
  * get generated in advance. The 'state' is used to keep the current
@@ -23,7 +48,7 @@
  */
 typedef struct {
     union {
-        uint8_t d[128]; /* MUST be 512, exactly */
+        uint8_t d[PRNG_BUFFER_BYTES];
         uint64_t dummy_u64;
     } buf;
     union {
@@ -33,6 +58,13 @@ typedef struct {
     size_t ptr;
     size_t ctr;
     int type;
+    /* Bytes output since the last seeding. */
+    uint64_t out_bytes;
+    /* Contexts seeded from the system (autoseed != 0) reseed themselves
+       when a fork happened since fork_gen was recorded, or once out_bytes
+       reaches PRNG_RESEED_BYTES; see randombytes.h. */
+    int autoseed;
+    unsigned fork_gen;
 } prng;
 
 /*
@@ -46,6 +78,18 @@ void prng_init(prng *p, const void *seed, size_t seed_len, uint64_t label);
  */
 int prng_get_bytes(prng *p, void *dst, size_t len);
 
+/*
+ * Refill the buffer of a PRNG with the next refill block.
+ */
+void prng_refill(prng *p);
+
+/*
+ * Get n 64-bit random values from a PRNG into dst. The values are the
+ * same as those of n successive calls to prng_get_u64(), but they are
+ * copied out of the buffer in runs instead of one at a time.
+ */
+void prng_get_u64_bulk(prng *p, uint64_t *dst, size_t n);
+
 /*
  * Get a 64-bit random value from a PRNG.
  */
@@ -57,8 +101,7 @@ prng_get_u64(prng *p)
     const uint8_t *ptr;
 
     if (p->ptr >= (sizeof p->buf) - 9) {
-        blake2s_expand(p->buf.d, sizeof p->buf.d, p->key.d, sizeof p->key.d, p->ctr++);
-        p->ptr = 0;
+        prng_refill(p);
     }
     ptr = p->buf.d + p->ptr;
     p->ptr += 8;
@@ -76,8 +119,7 @@ prng_get_u8(prng *p)
     unsigned v;
 
     if (p->ptr == sizeof p->buf.d) {
-        blake2s_expand(p->buf.d, sizeof p->buf.d, p->key.d, sizeof p->key.d, p->ctr++);
-        p->ptr = 0;
+        prng_refill(p);
     }
     v = p->buf.d[p->ptr ++];
     return v;
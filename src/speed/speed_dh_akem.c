@@ -1,6 +1,8 @@
 
 #include "dh_akem_api.h"
 #include "randombytes.h"
+#include "scalarmult.h"
+#include "fe.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -15,6 +17,8 @@
 #include "cycles.h"
 
 #define NTESTS 2048
+// Field operations are timed in runs of FE_OPS, so kilocycles read as cycles per operation.
+#define FE_OPS 1000
 uint64_t time0, time1;
 uint64_t cycles[NTESTS];
 
@@ -25,6 +29,12 @@ int main(void){
     nike_pk ct;
     nike_s s1;
     uint8_t nike_akem_secret1[NIKE_BYTES], nike_akem_secret2[NIKE_BYTES];
+    uint8_t q[32];
+    uint8_t n4[128], p4[128], q4[128];
+    fe25 f25;
+#if FE51_AVAILABLE
+    fe51 f51;
+#endif
 
     printf("NIKE AKEM public key bytes: %4zu\n", NIKE_PUBLICKEY_BYTES);
     printf("NIKE AKEM secret key bytes: %4zu\n", NIKE_SECRETKEY_BYTES);
@@ -58,6 +68,93 @@ int main(void){
 // ========
 // NIKE
 
+    printf("X25519 field arithmetic: %s\n", FE_RADIX51 ? "radix-2^51" : "radix-2^25.5");
+
+    WRAP_FUNC("scalarmult (ladder)",
+              "\\providecommand\\"
+              "DHLadder{",
+              cycles, time0, time1,
+              scalarmult(q, sk2.sk, pk2.pk),
+              "}");
+
+    WRAP_FUNC("scalarmult_base (ladder)",
+              "\\providecommand\\"
+              "DHBaseLadder{",
+              cycles, time0, time1,
+              scalarmult_base_ladder(q, sk2.sk),
+              "}");
+
+    WRAP_FUNC("scalarmult_base (fixed base)",
+              "\\providecommand\\"
+              "DHBaseFixed{",
+              cycles, time0, time1,
+              scalarmult_base(q, sk2.sk),
+              "}");
+
+    randombytes(n4, sizeof(n4));
+    randombytes(p4, sizeof(p4));
+    WRAP_FUNC("scalarmult x2",
+              "\\providecommand\\"
+              "DHLadderTwo{",
+              cycles, time0, time1,
+              scalarmult(q4, n4, p4); scalarmult(q4 + 32, n4 + 32, p4 + 32),
+              "}");
+
+    WRAP_FUNC("scalarmult_many x2",
+              "\\providecommand\\"
+              "DHLadderTwoShared{",
+              cycles, time0, time1,
+              scalarmult_many(q4, n4, p4, 2),
+              "}");
+
+
+    randombytes(p4, sizeof(p4));
+    WRAP_FUNC("scalarmult_x4",
+              "\\providecommand\\"
+              "DHLadderFour{",
+              cycles, time0, time1,
+              scalarmult_x4(q4, n4, p4),
+              "}");
+
+    WRAP_FUNC("scalarmult_x4_ref",
+              "\\providecommand\\"
+              "DHLadderFourRef{",
+              cycles, time0, time1,
+              scalarmult_x4_ref(q4, n4, p4),
+              "}");
+
+    fe25_frombytes(f25, pk2.pk);
+    WRAP_FUNC("fe25_mul x1000",
+              "\\providecommand\\"
+              "DHFeMulRadixTwentyFive{",
+              cycles, time0, time1,
+              for(size_t j = 0; j < FE_OPS; j++){ fe25_mul(f25, f25, f25); },
+              "}");
+
+    WRAP_FUNC("fe25_sq x1000",
+              "\\providecommand\\"
+              "DHFeSqRadixTwentyFive{",
+              cycles, time0, time1,
+              for(size_t j = 0; j < FE_OPS; j++){ fe25_sq(f25, f25); },
+              "}");
+
+#if FE51_AVAILABLE
+    fe51_frombytes(f51, pk2.pk);
+    WRAP_FUNC("fe51_mul x1000",
+              "\\providecommand\\"
+              "DHFeMulRadixFiftyOne{",
+              cycles, time0, time1,
+              for(size_t j = 0; j < FE_OPS; j++){ fe51_mul(f51, f51, f51); },
+              "}");
+
+    WRAP_FUNC("fe51_sq x1000",
+              "\\providecommand\\"
+              "DHFeSqRadixFiftyOne{",
+              cycles, time0, time1,
+              for(size_t j = 0; j < FE_OPS; j++){ fe51_sq(f51, f51); },
+              "}");
+#endif
+
     WRAP_FUNC("nike_keygen",
               "\\providecommand\\"
               "DHAKEMKeyGen{",
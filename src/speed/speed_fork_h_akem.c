@@ -0,0 +1,135 @@
+
+#include "randombytes.h"
+#include "h_akem_api.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Encapsulations (each checked by a decapsulation) per worker and per run.
+#define OPS_PER_WORKER 64
+#define MAX_WORKERS 256
+
+static h_akem_sk sender_sk, receiver_sk;
+static h_akem_pk sender_pk, receiver_pk;
+
+typedef struct {
+    uint32_t correct;
+    uint8_t first_secret[32];
+} worker_report;
+
+// Pre-fork model: the keys and the PRNG are set up in the parent before
+// the workers are forked, so every worker starts from a copy of the
+// parent's PRNG state.
+static
+void worker(int fd){
+
+    worker_report report;
+    h_akem_ct ct;
+    uint8_t sender_secret[32], receiver_secret[32];
+
+    report.correct = 0;
+    for(size_t i = 0; i < OPS_PER_WORKER; i++){
+        h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk);
+        report.correct += (h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk) == 1) &&
+                          (memcmp(sender_secret, receiver_secret, 32) == 0);
+        if(i == 0){
+            memcpy(report.first_secret, sender_secret, 32);
+        }
+    }
+
+    (void)!write(fd, &report, sizeof report);
+
+}
+
+static
+double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+int main(void){
+
+    static int fds[MAX_WORKERS][2];
+    static pid_t pids[MAX_WORKERS];
+    static worker_report reports[MAX_WORKERS];
+    long cores;
+    size_t nworkers, correct, distinct;
+    double t0, t1, rate, rate1 = 0;
+
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cores < 1){
+        cores = 1;
+    }
+    if(cores > MAX_WORKERS / 2){
+        cores = MAX_WORKERS / 2;
+    }
+
+    seed_rng();
+    h_akem_keygen(&sender_sk, &sender_pk);
+    h_akem_keygen(&receiver_sk, &receiver_pk);
+
+    printf(KEM_INSTANCE "-" RSIG_INSTANCE " h_akem_encap + h_akem_decap in forked workers, %d per worker, %ld cores\n",
+           OPS_PER_WORKER, cores);
+
+    // 1, 2, 4, ... workers up to the core count, then twice the core count.
+    nworkers = 1;
+    while(1){
+
+        t0 = now();
+        for(size_t i = 0; i < nworkers; i++){
+            if(pipe(fds[i]) != 0 || (pids[i] = fork()) < 0){
+                fprintf(stderr, "fork failed\n");
+                return 1;
+            }
+            if(pids[i] == 0){
+                close(fds[i][0]);
+                worker(fds[i][1]);
+                _exit(0);
+            }
+            close(fds[i][1]);
+        }
+        correct = 0;
+        for(size_t i = 0; i < nworkers; i++){
+            if(read(fds[i][0], reports + i, sizeof(worker_report)) != sizeof(worker_report)){
+                memset(reports + i, 0, sizeof(worker_report));
+            }
+            close(fds[i][0]);
+            waitpid(pids[i], NULL, 0);
+            correct += reports[i].correct;
+        }
+        t1 = now();
+
+        // Workers forked from the same state must still draw independent
+        // randomness, hence distinct first shared secrets.
+        distinct = 1;
+        for(size_t i = 0; i < nworkers; i++){
+            for(size_t j = 0; j < i; j++){
+                distinct &= (memcmp(reports[i].first_secret, reports[j].first_secret, 32) != 0);
+            }
+        }
+
+        rate = (double)(nworkers * OPS_PER_WORKER) / (t1 - t0);
+        if(nworkers == 1){
+            rate1 = rate;
+        }
+        printf("workers %3zu: %8.1f ops/s, speedup %5.2f, %zu/%zu correct, %s secrets (%s)\n",
+               nworkers, rate, rate / rate1, correct, nworkers * OPS_PER_WORKER,
+               distinct ? "distinct" : "REPEATED",
+               (correct == nworkers * OPS_PER_WORKER && distinct) ? "ok" : "ERROR!");
+
+        if(nworkers == 2 * (size_t)cores){
+            break;
+        }
+        nworkers = (nworkers < (size_t)cores && 2 * nworkers > (size_t)cores) ? (size_t)cores : 2 * nworkers;
+
+    }
+
+    return 0;
+
+}
@@ -3,6 +3,10 @@
 #include "randombytes.h"
 #include "h_akem_api.h"
 
+#ifdef RSIG_PERTURBATION_POOL
+#include "mitaka_sampler.h"
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,6 +23,10 @@
 uint64_t time0, time1;
 uint64_t cycles[NTESTS];
 
+#define BATCH_RECEIVERS 8
+
+#define MAX_RING_K 64
+
 #define SHARED_SECRET_LEN 64
 
 int main(void){
@@ -26,9 +34,32 @@ int main(void){
     h_akem_sk sender_sk, receiver_sk;
     h_akem_pk sender_pk, receiver_pk;
     h_akem_ct ct;
+    static h_akem_expanded_sk expanded_sk;
+    static h_akem_sk batch_sk[BATCH_RECEIVERS];
+    static h_akem_pk batch_pk[BATCH_RECEIVERS];
+    static h_akem_ct batch_ct[BATCH_RECEIVERS];
+    static uint8_t batch_secret[BATCH_RECEIVERS][32];
+    uint8_t batch_success[(BATCH_RECEIVERS + 7) / 8];
+    h_akem_peer_ctx peer_ctx;
+    static h_akem_nk_cache nk_cache;
     nike_s s;
     rsig_pk internal_rsig_pk;
+    static rsig_pk_prepared prepared_rsig_pk;
+    sign_sk member_sk;
+    sign_pk member_pk;
     rsig_signature internal_signature;
+    static sign_pk_ntt ring_members[MAX_RING_K];
+    const sign_pk_ntt *ring[MAX_RING_K];
+    static uint8_t ring_signature[RSIG_SIGNATURE_BYTES_K(MAX_RING_K)];
+    const size_t ring_sizes[] = {2, 4, 8, 16, 32, 64};
+    size_t ring_k;
+#ifdef RSIG_PERTURBATION_POOL
+    static sign_expanded_sk pool_sk;
+    static sign_perturbation pool_samples[NTESTS + NTESTS / 4];
+    static sign_perturbation one_sample;
+    static poly rounded;
+    sign_perturbation_pool pool, one_pool;
+#endif
     uint8_t sender_secret[32], receiver_secret[32];
     uint8_t kk[SHARED_SECRET_LEN];
     uint8_t m[NTESTS][MLEN];
@@ -67,6 +98,71 @@ int main(void){
               h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk),
               "}");
 
+    WRAP_FUNC("h_akem_expand_sk",
+              "",
+              cycles, time0, time1,
+              h_akem_expand_sk(&expanded_sk, &sender_sk),
+              "");
+
+    WRAP_FUNC("h_akem_encap_expanded_sk",
+              "",
+              cycles, time0, time1,
+              h_akem_encap_expanded_sk(sender_secret, &ct, &expanded_sk, &sender_pk, &receiver_pk),
+              "");
+
+    WRAP_FUNC("h_akem_peer_ctx_init_sender",
+              "",
+              cycles, time0, time1,
+              h_akem_peer_ctx_init_sender(&peer_ctx, &sender_sk, &sender_pk, &receiver_pk),
+              "");
+
+    WRAP_FUNC("h_akem_encap_ctx",
+              "",
+              cycles, time0, time1,
+              h_akem_encap_ctx(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk, &peer_ctx),
+              "");
+
+    h_akem_peer_ctx_init_receiver(&peer_ctx, &receiver_sk, &receiver_pk, &sender_pk);
+
+    WRAP_FUNC("h_akem_decap_ctx",
+              "",
+              cycles, time0, time1,
+              h_akem_decap_ctx(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk, &peer_ctx),
+              "");
+
+    // Repeated traffic between one pair: every call after the first hits
+    // the cache.
+    h_akem_nk_cache_init(&nk_cache);
+
+    WRAP_FUNC("h_akem_encap_cached",
+              "",
+              cycles, time0, time1,
+              h_akem_encap_cached(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk, &nk_cache),
+              "");
+
+    WRAP_FUNC("h_akem_decap_cached",
+              "",
+              cycles, time0, time1,
+              h_akem_decap_cached(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk, &nk_cache),
+              "");
+
+    h_akem_nk_cache_release(&nk_cache);
+
+    for(size_t i = 0; i < BATCH_RECEIVERS; i++){
+        h_akem_keygen(batch_sk + i, batch_pk + i);
+    }
+
+    printf("BATCH_RECEIVERS = %d\n", BATCH_RECEIVERS);
+    for(size_t i = 0; i < BATCH_RECEIVERS; i++){
+        h_akem_encap(batch_secret[i], batch_ct + i, batch_sk + i, batch_pk + i, &sender_pk);
+    }
+
+    WRAP_FUNC("h_akem_decap_batch",
+              "",
+              cycles, time0, time1,
+              h_akem_decap_batch(batch_secret[0], batch_success, batch_ct, &sender_sk, &sender_pk, batch_pk, BATCH_RECEIVERS),
+              "");
+
 // ========
 // nike operations
 
@@ -120,8 +216,12 @@ int main(void){
     sign_keygen(&receiver_sk.ssk, &receiver_pk.spk);
     sign_keygen(&sender_sk.ssk, &sender_pk.spk);
     internal_rsig_pk.hs[0] = sender_pk.spk;
-    internal_rsig_pk.hs[0] = receiver_pk.spk;
+    internal_rsig_pk.hs[1] = receiver_pk.spk;
+    for(size_t i = 2; i < RING_K; i++){
+        sign_keygen(&member_sk, internal_rsig_pk.hs + i);
+    }
     printf("MLEN = %d\n", MLEN);
+    printf("RING_K = %d\n", RING_K);
     WRAP_FUNC("Gandalf_sign",
               "\\providecommand\\" RSIG_INSTANCE
               "GandalfRSigSig{",
@@ -136,6 +236,114 @@ int main(void){
               Gandalf_verify(m[i], MLEN, &internal_signature, &internal_rsig_pk),
               "}");
 
+    WRAP_FUNC("Gandalf_prepare_pk",
+              "",
+              cycles, time0, time1,
+              Gandalf_prepare_pk(&prepared_rsig_pk, &internal_rsig_pk),
+              "");
+
+    WRAP_FUNC("Gandalf_sign_prepared",
+              "",
+              cycles, time0, time1,
+              Gandalf_sign_prepared(&internal_signature, m[i], MLEN, &prepared_rsig_pk, &sender_sk.ssk, 0),
+              "");
+
+    WRAP_FUNC("Gandalf_verify_prepared",
+              "",
+              cycles, time0, time1,
+              Gandalf_verify_prepared(m[i], MLEN, &internal_signature, &prepared_rsig_pk),
+              "");
+
+#ifdef RSIG_PERTURBATION_POOL
+    // Offline part of signing, one perturbation at a time, then signing
+    // from a pool filled ahead; attempts beyond the pool sample inline.
+    expand_sign_sk(&pool_sk, &sender_sk.ssk);
+    sign_perturbation_pool_init(&one_pool, &pool_sk, &one_sample, 1);
+    WRAP_FUNC("sign_perturbation_pool_refill",
+              "",
+              cycles, time0, time1,
+              (sign_perturbation_pool_release(&one_pool), sign_perturbation_pool_refill(&one_pool, 1)),
+              "");
+    sign_perturbation_pool_release(&one_pool);
+
+    // Box-Muller for one perturbation: dispatched kernel against libm.
+    WRAP_FUNC("normaldist",
+              "",
+              cycles, time0, time1,
+              normaldist(&one_sample.FFTy1),
+              "");
+
+    WRAP_FUNC("normaldist_ref",
+              "",
+              cycles, time0, time1,
+              normaldist_ref(&one_sample.FFTy1),
+              "");
+
+    // Nearest-plane rounding of one polynomial: batched against scalar samplerZ.
+    WRAP_FUNC("sample_discrete_gauss",
+              "",
+              cycles, time0, time1,
+              sample_discrete_gauss(&rounded, &one_sample.FFTy1),
+              "");
+
+    WRAP_FUNC("sample_discrete_gauss_ref",
+              "",
+              cycles, time0, time1,
+              sample_discrete_gauss_ref(&rounded, &one_sample.FFTy1),
+              "");
+
+    sign_perturbation_pool_init(&pool, &pool_sk, pool_samples, NTESTS + NTESTS / 4);
+    sign_perturbation_pool_refill(&pool, NTESTS + NTESTS / 4);
+    WRAP_FUNC("Gandalf_sign_prepared_pool",
+              "",
+              cycles, time0, time1,
+              Gandalf_sign_prepared_pool(&internal_signature, m[i], MLEN, &prepared_rsig_pk, &pool, 0),
+              "");
+    sign_perturbation_pool_release(&pool);
+
+    WRAP_FUNC("Gandalf_sign_prepared_expanded_sk",
+              "",
+              cycles, time0, time1,
+              Gandalf_sign_prepared_expanded_sk(&internal_signature, m[i], MLEN, &prepared_rsig_pk, &pool_sk, 0),
+              "");
+#endif
+
+    // Rings of run-time size; the sender signs as member 0.
+    sign_pk_to_ntt(ring_members, &sender_pk.spk);
+    ring[0] = ring_members;
+    for(size_t j = 1; j < MAX_RING_K; j++){
+        sign_keygen(&member_sk, &member_pk);
+        sign_pk_to_ntt(ring_members + j, &member_pk);
+        ring[j] = ring_members + j;
+    }
+
+    for(size_t j = 0; j < sizeof(ring_sizes) / sizeof(ring_sizes[0]); j++){
+
+        ring_k = ring_sizes[j];
+        printf("ring size = %zu\n", ring_k);
+
+        WRAP_FUNC("Gandalf_sign_k",
+                  "",
+                  cycles, time0, time1,
+                  Gandalf_sign_k(ring_signature, m[i], MLEN, ring, ring_k, &sender_sk.ssk, 0),
+                  "");
+#ifdef __MEDIAN__
+        printf("Gandalf_sign_k per member median cycles:\n" CYCLE_TYPE "\n",
+               WRAP_WITH_UNIT(cycles[NTESTS >> 1] / ring_k));
+#endif
+
+        WRAP_FUNC("Gandalf_verify_k",
+                  "",
+                  cycles, time0, time1,
+                  Gandalf_verify_k(m[i], MLEN, ring_signature, ring, ring_k),
+                  "");
+#ifdef __MEDIAN__
+        printf("Gandalf_verify_k per member median cycles:\n" CYCLE_TYPE "\n",
+               WRAP_WITH_UNIT(cycles[NTESTS >> 1] / ring_k));
+#endif
+
+    }
+
     return 0;
 
 }
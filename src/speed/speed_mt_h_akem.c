@@ -0,0 +1,121 @@
+
+#include "randombytes.h"
+#include "h_akem_api.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Encapsulations (each checked by a decapsulation) per thread and per run.
+#define OPS_PER_THREAD 64
+#define MAX_THREADS 256
+
+static h_akem_sk sender_sk, receiver_sk;
+static h_akem_pk sender_pk, receiver_pk;
+
+typedef struct {
+    int use_own_ctx;
+    int correct;
+} worker_arg;
+
+// Half of the workers install a caller-owned context, the other half use
+// the default thread-local one.
+static
+void *worker(void *varg){
+
+    worker_arg *arg = varg;
+    prng own;
+    h_akem_ct ct;
+    uint8_t sender_secret[32], receiver_secret[32];
+
+    if(arg->use_own_ctx){
+        seed_prng_ctx(&own);
+        set_prng_ctx(&own);
+    }
+
+    arg->correct = 0;
+    for(size_t i = 0; i < OPS_PER_THREAD; i++){
+        h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk);
+        arg->correct += (h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk) == 1) &&
+                        (memcmp(sender_secret, receiver_secret, 32) == 0);
+    }
+
+    if(arg->use_own_ctx){
+        set_prng_ctx(NULL);
+    }
+
+    return NULL;
+
+}
+
+static
+double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+int main(void){
+
+    static pthread_t threads[MAX_THREADS];
+    static worker_arg args[MAX_THREADS];
+    long cores;
+    size_t nthreads, correct;
+    double t0, t1, rate, rate1 = 0;
+
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cores < 1){
+        cores = 1;
+    }
+    if(cores > MAX_THREADS / 2){
+        cores = MAX_THREADS / 2;
+    }
+
+    seed_rng();
+    h_akem_keygen(&sender_sk, &sender_pk);
+    h_akem_keygen(&receiver_sk, &receiver_pk);
+
+    printf(KEM_INSTANCE "-" RSIG_INSTANCE " h_akem_encap + h_akem_decap, %d per thread, %ld cores\n",
+           OPS_PER_THREAD, cores);
+
+    // 1, 2, 4, ... threads up to the core count, then twice the core count.
+    nthreads = 1;
+    while(1){
+
+        t0 = now();
+        for(size_t i = 0; i < nthreads; i++){
+            args[i].use_own_ctx = (int)(i & 1);
+            if(pthread_create(threads + i, NULL, worker, args + i) != 0){
+                fprintf(stderr, "pthread_create failed\n");
+                return 1;
+            }
+        }
+        correct = 0;
+        for(size_t i = 0; i < nthreads; i++){
+            pthread_join(threads[i], NULL);
+            correct += args[i].correct;
+        }
+        t1 = now();
+
+        rate = (double)(nthreads * OPS_PER_THREAD) / (t1 - t0);
+        if(nthreads == 1){
+            rate1 = rate;
+        }
+        printf("threads %3zu: %8.1f ops/s, speedup %5.2f, %zu/%zu correct (%s)\n",
+               nthreads, rate, rate / rate1, correct, nthreads * OPS_PER_THREAD,
+               (correct == nthreads * OPS_PER_THREAD) ? "ok" : "ERROR!");
+
+        if(nthreads == 2 * (size_t)cores){
+            break;
+        }
+        nthreads = (nthreads < (size_t)cores && 2 * nthreads > (size_t)cores) ? (size_t)cores : 2 * nthreads;
+
+    }
+
+    return 0;
+
+}
@@ -20,6 +20,8 @@
 uint64_t time0, time1;
 uint64_t cycles[NTESTS];
 
+#define BATCH_RECEIVERS 8
+
 #define SHARED_SECRET_LEN 48
 
 int main(){
@@ -27,6 +29,12 @@ int main(){
     pq_akem_sk sender_sk, receiver_sk;
     pq_akem_pk sender_pk, receiver_pk;
     pq_akem_ct ct;
+    static pq_akem_expanded_sk expanded_sk;
+    static pq_akem_sk batch_sk[BATCH_RECEIVERS];
+    static pq_akem_pk batch_pk[BATCH_RECEIVERS];
+    static pq_akem_ct batch_ct[BATCH_RECEIVERS];
+    static uint8_t batch_secret[BATCH_RECEIVERS][32];
+    uint8_t batch_success[(BATCH_RECEIVERS + 7) / 8];
     rsig_pk internal_rsig_pk;
     rsig_signature internal_signature;
     poly a, b, c;
@@ -77,6 +85,33 @@ int main(){
               pq_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk),
               "}");
 
+    WRAP_FUNC("pq_akem_expand_sk",
+              "",
+              cycles, time0, time1,
+              pq_akem_expand_sk(&expanded_sk, &sender_sk),
+              "");
+
+    WRAP_FUNC("pq_akem_encap_expanded_sk",
+              "",
+              cycles, time0, time1,
+              pq_akem_encap_expanded_sk(sender_secret, &ct, &expanded_sk, &sender_pk, &receiver_pk),
+              "");
+
+    for(size_t i = 0; i < BATCH_RECEIVERS; i++){
+        pq_akem_keygen(batch_sk + i, batch_pk + i);
+    }
+
+    printf("BATCH_RECEIVERS = %d\n", BATCH_RECEIVERS);
+    for(size_t i = 0; i < BATCH_RECEIVERS; i++){
+        pq_akem_encap(batch_secret[i], batch_ct + i, batch_sk + i, batch_pk + i, &sender_pk);
+    }
+
+    WRAP_FUNC("pq_akem_decap_batch",
+              "",
+              cycles, time0, time1,
+              pq_akem_decap_batch(batch_secret[0], batch_success, batch_ct, &sender_sk, &sender_pk, batch_pk, BATCH_RECEIVERS),
+              "");
+
 // ========
 // kem operations
 
@@ -0,0 +1,61 @@
+
+#include "randombytes.h"
+#include "chacha20.h"
+#include "blake2.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cycles.h"
+
+#define NTESTS 2048
+#define BYTES 4096
+
+// Bytes per cycle of each generator, from the median over NTESTS runs of
+// BYTES bytes (a Mitaka signature draws about 16 KiB through randombytes
+// and 30 KiB through get64).
+#define SPEED_BYTES(name, func) { \
+    for(size_t i = 0; i < NTESTS; i++){ \
+        time0 = get_cycle(); \
+        func; \
+        time1 = get_cycle(); \
+        cycles[i] = time1 - time0; \
+    } \
+    qsort(cycles, NTESTS, sizeof(uint64_t), cmp_cycles); \
+    printf("%-24s %6.3f bytes/cycle (%5.2f cycles/byte)\n", name, \
+           (double)BYTES / (double)cycles[NTESTS >> 1], (double)cycles[NTESTS >> 1] / (double)BYTES); \
+}
+
+uint64_t time0, time1;
+uint64_t cycles[NTESTS];
+
+static int cmp_cycles(const void *a, const void *b){
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(void){
+
+    static uint8_t buf[BYTES];
+    static uint64_t words[BYTES / 8];
+    uint8_t key[32] = {0}, nonce[12] = {0};
+    volatile uint64_t sink = 0;
+
+    init_prng();
+    init_counter();
+
+    printf("PRNG backend: %s, refill block %d bytes\n",
+           PRNG_CHACHA20 ? "ChaCha20" : "BLAKE2s", PRNG_BUFFER_BYTES);
+
+    SPEED_BYTES("blake2s_expand", blake2s_expand(buf, BYTES, key, sizeof key, i));
+    SPEED_BYTES("chacha20_blocks_ref", chacha20_blocks_ref(buf, BYTES / 64, key, nonce, 0));
+    SPEED_BYTES("chacha20_blocks", chacha20_blocks(buf, BYTES / 64, key, nonce, 0));
+    SPEED_BYTES("randombytes", randombytes(buf, BYTES));
+    SPEED_BYTES("get64_bulk", get64_bulk(words, BYTES / 8));
+    SPEED_BYTES("get64", for(size_t j = 0; j < BYTES / 8; j++){ sink += get64(); });
+
+    return (int)(sink & 0);
+
+}
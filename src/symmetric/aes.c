@@ -31,6 +31,47 @@
 
 #include "aes.h"
 
+/* Define AES_AESNI to 0 in order to disable the AES-NI engine, or AES_ARMV8
+   to 1 on aarch64 Linux or macOS to enable the ARMv8 AES engine; the latter
+   is off by default until it has been built and tested on an aarch64 target.
+   Both are selected at runtime, so the bitsliced code still runs on CPUs
+   without the instructions. */
+#ifndef AES_AESNI
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__)
+#define AES_AESNI   1
+#else
+#define AES_AESNI   0
+#endif
+#endif
+
+#ifndef AES_ARMV8
+#define AES_ARMV8   0
+#endif
+#if AES_ARMV8 && !(defined __aarch64__ && (defined __GNUC__ || defined __clang__) \
+    && (defined __linux__ || defined __APPLE__))
+#error "AES_ARMV8 needs an aarch64 Linux or macOS target and GCC or Clang"
+#endif
+
+#if AES_AESNI
+#include <immintrin.h>
+#define TARGET_AESNI   __attribute__((target("aes,ssse3")))
+#endif
+
+#if AES_ARMV8
+#include <arm_neon.h>
+#if defined __clang__
+#define TARGET_ARMV8_AES   __attribute__((target("aes")))
+#else
+#define TARGET_ARMV8_AES   __attribute__((target("+crypto")))
+#endif
+#if defined __linux__
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES   (1 << 3)
+#endif
+#endif
+#endif
+
 static inline uint32_t br_dec32le(const unsigned char *src) {
     return (uint32_t)src[0]
            | ((uint32_t)src[1] << 8)
@@ -571,17 +612,19 @@ static void aes_ctr(unsigned char *out, const unsigned char *in, size_t len,
     ivw[11] = br_swap32(cc + 2);
     ivw[15] = br_swap32(cc + 3);
 
+    unsigned char tmp[64];
+
+    // The key stream goes through tmp, so out may equal in.
     while(len > 64){
-        aes_ctr4x(out, ivw, rkeys, nrounds);
+        aes_ctr4x(tmp, ivw, rkeys, nrounds);
         for(size_t i = 0; i < 64; i++){
-            out[i] ^= in[i];
+            out[i] = tmp[i] ^ in[i];
         }
         in += 64;
         out += 64;
         len -= 64;
     }
     if(len > 0){
-        unsigned char tmp[64];
         aes_ctr4x(tmp, ivw, rkeys, nrounds);
         for(size_t i = 0; i < len; i++){
             out[i] = tmp[i] ^ in[i];
@@ -590,22 +633,354 @@ static void aes_ctr(unsigned char *out, const unsigned char *in, size_t len,
 
 }
 
-void aes128_ecb_keyexp(aes128ctx *r, const unsigned char *key) {
+/*
+ * Hardware AES-128. The round keys are the 11 standard 16-byte round keys
+ * stored in the first 22 words of sk_exp. The counter block is the 12-byte
+ * IV followed by a 32-bit big-endian block counter starting at 0, as in
+ * aes_ctr above. A NULL input yields the raw key stream.
+ */
+
+#if AES_AESNI
+
+#define AESNI_EXPAND(k, rcon) { \
+    __m128i t_ = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k, rcon), 0xFF); \
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4)); \
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4)); \
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4)); \
+    k = _mm_xor_si128(k, t_); \
+}
+
+TARGET_AESNI
+static void aes128_keyexp_aesni(uint64_t *sk_exp, const unsigned char *key) {
+    __m128i rk[11];
+    __m128i k = _mm_loadu_si128((const __m128i *)key);
+
+    rk[0] = k;
+    AESNI_EXPAND(k, 0x01); rk[1] = k;
+    AESNI_EXPAND(k, 0x02); rk[2] = k;
+    AESNI_EXPAND(k, 0x04); rk[3] = k;
+    AESNI_EXPAND(k, 0x08); rk[4] = k;
+    AESNI_EXPAND(k, 0x10); rk[5] = k;
+    AESNI_EXPAND(k, 0x20); rk[6] = k;
+    AESNI_EXPAND(k, 0x40); rk[7] = k;
+    AESNI_EXPAND(k, 0x80); rk[8] = k;
+    AESNI_EXPAND(k, 0x1B); rk[9] = k;
+    AESNI_EXPAND(k, 0x36); rk[10] = k;
+    for (int i = 0; i < 11; i++) {
+        _mm_storeu_si128((__m128i *)(sk_exp + 2 * i), rk[i]);
+    }
+}
+
+TARGET_AESNI
+static inline __m128i aes128_block_aesni(__m128i b, const __m128i *rk) {
+    b = _mm_xor_si128(b, rk[0]);
+    for (int r = 1; r < 10; r++) {
+        b = _mm_aesenc_si128(b, rk[r]);
+    }
+    return _mm_aesenclast_si128(b, rk[10]);
+}
+
+TARGET_AESNI
+static void aes128_ecb_aesni(unsigned char *out, const unsigned char *in, size_t nblocks, const uint64_t *sk_exp) {
+    __m128i rk[11];
+
+    for (int i = 0; i < 11; i++) {
+        rk[i] = _mm_loadu_si128((const __m128i *)(sk_exp + 2 * i));
+    }
+    for (size_t i = 0; i < nblocks; i++) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + 16 * i));
+        _mm_storeu_si128((__m128i *)(out + 16 * i), aes128_block_aesni(b, rk));
+    }
+}
+
+TARGET_AESNI
+static void aes128_ctr_aesni(unsigned char *out, const unsigned char *in, size_t len,
+                             const unsigned char *iv, const uint64_t *sk_exp) {
+    __m128i rk[11];
+    __m128i b[8];
+    unsigned char tmp[16];
+    /* Byte-swaps the counter lane, leaving the IV bytes in place. */
+    const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i one = _mm_set_epi32(1, 0, 0, 0);
+    __m128i ctr;
+
+    for (int i = 0; i < 11; i++) {
+        rk[i] = _mm_loadu_si128((const __m128i *)(sk_exp + 2 * i));
+    }
+    ctr = _mm_set_epi32(0, (int)br_dec32le(iv + 8), (int)br_dec32le(iv + 4), (int)br_dec32le(iv));
+
+    /* Eight independent blocks keep the AES unit busy. */
+    while (len >= 128) {
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm_xor_si128(_mm_shuffle_epi8(ctr, bswap), rk[0]);
+            ctr = _mm_add_epi32(ctr, one);
+        }
+        for (int r = 1; r < 10; r++) {
+            for (int j = 0; j < 8; j++) {
+                b[j] = _mm_aesenc_si128(b[j], rk[r]);
+            }
+        }
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm_aesenclast_si128(b[j], rk[10]);
+            if (in != NULL) {
+                b[j] = _mm_xor_si128(b[j], _mm_loadu_si128((const __m128i *)(in + 16 * j)));
+            }
+            _mm_storeu_si128((__m128i *)(out + 16 * j), b[j]);
+        }
+        if (in != NULL) {
+            in += 128;
+        }
+        out += 128;
+        len -= 128;
+    }
+    while (len > 0) {
+        size_t n = len < 16 ? len : 16;
+
+        b[0] = aes128_block_aesni(_mm_shuffle_epi8(ctr, bswap), rk);
+        ctr = _mm_add_epi32(ctr, one);
+        _mm_storeu_si128((__m128i *)tmp, b[0]);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = in != NULL ? (unsigned char)(tmp[i] ^ in[i]) : tmp[i];
+        }
+        if (in != NULL) {
+            in += n;
+        }
+        out += n;
+        len -= n;
+    }
+}
+
+#endif
+
+#if AES_ARMV8
+
+TARGET_ARMV8_AES
+static uint32_t sub_word_armv8(uint32_t x) {
+    /* AESE with a zero key is SubBytes(ShiftRows(.)); with four equal
+       columns the ShiftRows is a no-op. */
+    uint8x16_t t = vreinterpretq_u8_u32(vdupq_n_u32(x));
+
+    t = vaeseq_u8(t, vdupq_n_u8(0));
+    return vgetq_lane_u32(vreinterpretq_u32_u8(t), 0);
+}
+
+TARGET_ARMV8_AES
+static void aes128_keyexp_armv8(uint64_t *sk_exp, const unsigned char *key) {
+    uint32_t w[44];
+
+    br_range_dec32le(w, 4, key);
+    for (int i = 4; i < 44; i++) {
+        uint32_t t = w[i - 1];
+
+        if ((i & 3) == 0) {
+            t = sub_word_armv8((t >> 8) | (t << 24)) ^ Rcon[(i >> 2) - 1];
+        }
+        w[i] = w[i - 4] ^ t;
+    }
+    br_range_enc32le((unsigned char *)sk_exp, w, 44);
+}
+
+TARGET_ARMV8_AES
+static inline uint8x16_t aes128_block_armv8(uint8x16_t b, const uint8x16_t *rk) {
+    for (int r = 0; r < 9; r++) {
+        b = vaesmcq_u8(vaeseq_u8(b, rk[r]));
+    }
+    return veorq_u8(vaeseq_u8(b, rk[9]), rk[10]);
+}
+
+TARGET_ARMV8_AES
+static void aes128_ecb_armv8(unsigned char *out, const unsigned char *in, size_t nblocks, const uint64_t *sk_exp) {
+    uint8x16_t rk[11];
+
+    for (int i = 0; i < 11; i++) {
+        rk[i] = vld1q_u8((const uint8_t *)(sk_exp + 2 * i));
+    }
+    for (size_t i = 0; i < nblocks; i++) {
+        vst1q_u8(out + 16 * i, aes128_block_armv8(vld1q_u8(in + 16 * i), rk));
+    }
+}
+
+TARGET_ARMV8_AES
+static void aes128_ctr_armv8(unsigned char *out, const unsigned char *in, size_t len,
+                             const unsigned char *iv, const uint64_t *sk_exp) {
+    uint8x16_t rk[11];
+    uint8x16_t b[8];
+    unsigned char tmp[16];
+    uint32x4_t nonce;
+    uint32_t cc = 0;
+
+    for (int i = 0; i < 11; i++) {
+        rk[i] = vld1q_u8((const uint8_t *)(sk_exp + 2 * i));
+    }
+    memcpy(tmp, iv, 12);
+    memset(tmp + 12, 0, 4);
+    nonce = vreinterpretq_u32_u8(vld1q_u8(tmp));
+
+    /* Eight independent blocks keep the AES unit busy. */
+    while (len >= 128) {
+        for (int j = 0; j < 8; j++) {
+            b[j] = vreinterpretq_u8_u32(vsetq_lane_u32(br_swap32(cc++), nonce, 3));
+        }
+        for (int r = 0; r < 9; r++) {
+            for (int j = 0; j < 8; j++) {
+                b[j] = vaesmcq_u8(vaeseq_u8(b[j], rk[r]));
+            }
+        }
+        for (int j = 0; j < 8; j++) {
+            b[j] = veorq_u8(vaeseq_u8(b[j], rk[9]), rk[10]);
+            if (in != NULL) {
+                b[j] = veorq_u8(b[j], vld1q_u8(in + 16 * j));
+            }
+            vst1q_u8(out + 16 * j, b[j]);
+        }
+        if (in != NULL) {
+            in += 128;
+        }
+        out += 128;
+        len -= 128;
+    }
+    while (len > 0) {
+        size_t n = len < 16 ? len : 16;
+
+        b[0] = vreinterpretq_u8_u32(vsetq_lane_u32(br_swap32(cc++), nonce, 3));
+        vst1q_u8(tmp, aes128_block_armv8(b[0], rk));
+        for (size_t i = 0; i < n; i++) {
+            out[i] = in != NULL ? (unsigned char)(tmp[i] ^ in[i]) : tmp[i];
+        }
+        if (in != NULL) {
+            in += n;
+        }
+        out += n;
+        len -= n;
+    }
+}
+
+#endif
+
+unsigned aes128_backend(void) {
+#if AES_AESNI
+    if (__builtin_cpu_supports("aes") && __builtin_cpu_supports("ssse3")) {
+        return AES128_BACKEND_AESNI;
+    }
+#endif
+#if AES_ARMV8
+#if defined __APPLE__
+    return AES128_BACKEND_ARMV8;
+#else
+    if (getauxval(AT_HWCAP) & HWCAP_AES) {
+        return AES128_BACKEND_ARMV8;
+    }
+#endif
+#endif
+    return AES128_BACKEND_BITSLICED;
+}
+
+static void aes128_keyexp_backend(uint64_t *sk_exp, const unsigned char *key, unsigned backend) {
     uint64_t skey[22];
 
+#if AES_AESNI
+    if (backend == AES128_BACKEND_AESNI) {
+        aes128_keyexp_aesni(sk_exp, key);
+        return;
+    }
+#endif
+#if AES_ARMV8
+    if (backend == AES128_BACKEND_ARMV8) {
+        aes128_keyexp_armv8(sk_exp, key);
+        return;
+    }
+#endif
+    (void)backend;
+    br_aes_ct64_keysched(skey, key, 16);
+    br_aes_ct64_skey_expand(sk_exp, skey, 10);
+}
+
+static void aes128_ecb_backend(unsigned char *out, const unsigned char *in, size_t nblocks,
+                               const uint64_t *sk_exp, unsigned backend) {
+#if AES_AESNI
+    if (backend == AES128_BACKEND_AESNI) {
+        aes128_ecb_aesni(out, in, nblocks, sk_exp);
+        return;
+    }
+#endif
+#if AES_ARMV8
+    if (backend == AES128_BACKEND_ARMV8) {
+        aes128_ecb_armv8(out, in, nblocks, sk_exp);
+        return;
+    }
+#endif
+    (void)backend;
+    aes_ecb(out, in, nblocks, sk_exp, 10);
+}
+
+static void aes128_ctr_backend(unsigned char *out, const unsigned char *in, size_t len,
+                               const unsigned char *iv, const uint64_t *sk_exp, unsigned backend) {
+#if AES_AESNI
+    if (backend == AES128_BACKEND_AESNI) {
+        aes128_ctr_aesni(out, in, len, iv, sk_exp);
+        return;
+    }
+#endif
+#if AES_ARMV8
+    if (backend == AES128_BACKEND_ARMV8) {
+        aes128_ctr_armv8(out, in, len, iv, sk_exp);
+        return;
+    }
+#endif
+    (void)backend;
+    if (in == NULL) {
+        aes_ctr_stream(out, len, iv, sk_exp, 10);
+    } else {
+        aes_ctr(out, in, len, iv, sk_exp, 10);
+    }
+}
+
+void aes128_ecb_keyexp(aes128ctx *r, const unsigned char *key) {
     r->sk_exp = malloc(sizeof(uint64_t) * PQC_AES128_STATESIZE);
     if (r->sk_exp == NULL) {
         exit(111);
     }
 
-    br_aes_ct64_keysched(skey, key, 16);
-    br_aes_ct64_skey_expand(r->sk_exp, skey, 10);
+    r->backend = aes128_backend();
+    aes128_keyexp_backend(r->sk_exp, key, r->backend);
+}
+
+void aes128_ecb_keyexp_ref(aes128ctx *r, const unsigned char *key) {
+    r->sk_exp = malloc(sizeof(uint64_t) * PQC_AES128_STATESIZE);
+    if (r->sk_exp == NULL) {
+        exit(111);
+    }
+
+    r->backend = AES128_BACKEND_BITSLICED;
+    aes128_keyexp_backend(r->sk_exp, key, r->backend);
 }
 
 void aes128_ctr_keyexp(aes128ctx *r, const unsigned char *key) {
     aes128_ecb_keyexp(r, key);
 }
 
+void aes128_ctr_keyexp_ref(aes128ctx *r, const unsigned char *key) {
+    aes128_ecb_keyexp_ref(r, key);
+}
+
+void aes128_ecb_keyexp_inline(aes128ctx_inline *r, const unsigned char *key) {
+    r->backend = aes128_backend();
+    aes128_keyexp_backend(r->sk_exp, key, r->backend);
+}
+
+void aes128_ctr_keyexp_inline(aes128ctx_inline *r, const unsigned char *key) {
+    aes128_ecb_keyexp_inline(r, key);
+}
+
+void aes128_ecb_keyexp_inline_ref(aes128ctx_inline *r, const unsigned char *key) {
+    r->backend = AES128_BACKEND_BITSLICED;
+    aes128_keyexp_backend(r->sk_exp, key, r->backend);
+}
+
+void aes128_ctr_keyexp_inline_ref(aes128ctx_inline *r, const unsigned char *key) {
+    aes128_ecb_keyexp_inline_ref(r, key);
+}
+
 void aes192_ecb_keyexp(aes192ctx *r, const unsigned char *key) {
     uint64_t skey[26];
     r->sk_exp = malloc(sizeof(uint64_t) * PQC_AES192_STATESIZE);
@@ -637,15 +1012,35 @@ void aes256_ctr_keyexp(aes256ctx *r, const unsigned char *key) {
 }
 
 void aes128_ecb(unsigned char *out, const unsigned char *in, size_t nblocks, const aes128ctx *ctx) {
-    aes_ecb(out, in, nblocks, ctx->sk_exp, 10);
+    aes128_ecb_backend(out, in, nblocks, ctx->sk_exp, ctx->backend);
 }
 
 void aes128_ctr_stream(unsigned char *out, size_t outlen, const unsigned char *iv, const aes128ctx *ctx) {
-    aes_ctr_stream(out, outlen, iv, ctx->sk_exp, 10);
+    aes128_ctr_backend(out, NULL, outlen, iv, ctx->sk_exp, ctx->backend);
 }
 
 void aes128_ctr(unsigned char *out, const unsigned char *in, size_t len, const unsigned char *iv, const aes128ctx *ctx){
-    aes_ctr(out, in, len, iv, ctx->sk_exp, 10);
+    aes128_ctr_backend(out, in, len, iv, ctx->sk_exp, ctx->backend);
+}
+
+void aes128_ctr_inplace(unsigned char *buf, size_t len, const unsigned char *iv, const aes128ctx *ctx){
+    aes128_ctr_backend(buf, buf, len, iv, ctx->sk_exp, ctx->backend);
+}
+
+void aes128_ecb_inline(unsigned char *out, const unsigned char *in, size_t nblocks, const aes128ctx_inline *ctx) {
+    aes128_ecb_backend(out, in, nblocks, ctx->sk_exp, ctx->backend);
+}
+
+void aes128_ctr_stream_inline(unsigned char *out, size_t outlen, const unsigned char *iv, const aes128ctx_inline *ctx) {
+    aes128_ctr_backend(out, NULL, outlen, iv, ctx->sk_exp, ctx->backend);
+}
+
+void aes128_ctr_inline(unsigned char *out, const unsigned char *in, size_t len, const unsigned char *iv, const aes128ctx_inline *ctx){
+    aes128_ctr_backend(out, in, len, iv, ctx->sk_exp, ctx->backend);
+}
+
+void aes128_ctr_inplace_inline(unsigned char *buf, size_t len, const unsigned char *iv, const aes128ctx_inline *ctx){
+    aes128_ctr_backend(buf, buf, len, iv, ctx->sk_exp, ctx->backend);
 }
 
 void aes192_ecb(unsigned char *out, const unsigned char *in, size_t nblocks, const aes192ctx *ctx) {
@@ -676,6 +1071,13 @@ void aes128_ctx_release(aes128ctx *r) {
     free(r->sk_exp);
 }
 
+void aes128_ctx_inline_release(aes128ctx_inline *r) {
+    volatile uint64_t *p = r->sk_exp;
+    for (size_t i = 0; i < PQC_AES128_STATESIZE; i++) {
+        p[i] = 0;
+    }
+}
+
 void aes192_ctx_release(aes192ctx *r) {
     free(r->sk_exp);
 }
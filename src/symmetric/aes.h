@@ -10,12 +10,28 @@
 #define AESCTR_NONCEBYTES 12
 #define AES_BLOCKBYTES 16
 
+// AES-128 engines. The keyexp functions pick AES-NI or (when built with
+// AES_ARMV8) the ARMv8 AES instructions when the CPU has them, and the
+// bitsliced code otherwise; the context records which one its round keys
+// are laid out for.
+#define AES128_BACKEND_BITSLICED 0
+#define AES128_BACKEND_AESNI 1
+#define AES128_BACKEND_ARMV8 2
+
 // We've put these states on the heap to make sure ctx_release is used.
 #define PQC_AES128_STATESIZE 88
 typedef struct {
     uint64_t *sk_exp;
+    unsigned backend;
 } aes128ctx;
 
+// Same key schedule held in the context itself, for callers that must not
+// touch the heap. Release only wipes the round keys.
+typedef struct {
+    uint64_t sk_exp[PQC_AES128_STATESIZE];
+    unsigned backend;
+} aes128ctx_inline;
+
 #define PQC_AES192_STATESIZE 104
 typedef struct {
     uint64_t  *sk_exp;
@@ -26,20 +42,52 @@ typedef struct {
     uint64_t *sk_exp;
 } aes256ctx;
 
+/** Engine the AES-128 keyexp functions select on this CPU **/
+unsigned aes128_backend(void);
+
 /** Initializes the context **/
 void aes128_ecb_keyexp(aes128ctx *r, const unsigned char *key);
 
 void aes128_ctr_keyexp(aes128ctx *r, const unsigned char *key);
 
+/** Initializes the context for the bitsliced engine regardless of the CPU **/
+void aes128_ecb_keyexp_ref(aes128ctx *r, const unsigned char *key);
+
+void aes128_ctr_keyexp_ref(aes128ctx *r, const unsigned char *key);
+
 void aes128_ecb(unsigned char *out, const unsigned char *in, size_t nblocks, const aes128ctx *ctx);
 
 void aes128_ctr_stream(unsigned char *out, size_t outlen, const unsigned char *iv, const aes128ctx *ctx);
 
+/** out may equal in **/
 void aes128_ctr(unsigned char *out, const unsigned char *in, size_t len, const unsigned char *iv, const aes128ctx *ctx);
 
+void aes128_ctr_inplace(unsigned char *buf, size_t len, const unsigned char *iv, const aes128ctx *ctx);
+
 /** Frees the context **/
 void aes128_ctx_release(aes128ctx *r);
 
+/** Initializes the inline context **/
+void aes128_ecb_keyexp_inline(aes128ctx_inline *r, const unsigned char *key);
+
+void aes128_ctr_keyexp_inline(aes128ctx_inline *r, const unsigned char *key);
+
+void aes128_ecb_keyexp_inline_ref(aes128ctx_inline *r, const unsigned char *key);
+
+void aes128_ctr_keyexp_inline_ref(aes128ctx_inline *r, const unsigned char *key);
+
+void aes128_ecb_inline(unsigned char *out, const unsigned char *in, size_t nblocks, const aes128ctx_inline *ctx);
+
+void aes128_ctr_stream_inline(unsigned char *out, size_t outlen, const unsigned char *iv, const aes128ctx_inline *ctx);
+
+/** out may equal in **/
+void aes128_ctr_inline(unsigned char *out, const unsigned char *in, size_t len, const unsigned char *iv, const aes128ctx_inline *ctx);
+
+void aes128_ctr_inplace_inline(unsigned char *buf, size_t len, const unsigned char *iv, const aes128ctx_inline *ctx);
+
+/** Wipes the inline context **/
+void aes128_ctx_inline_release(aes128ctx_inline *r);
+
 /** Initializes the context **/
 void aes192_ecb_keyexp(aes192ctx *r, const unsigned char *key);
 
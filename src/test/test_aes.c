@@ -0,0 +1,119 @@
+
+#include "aes.h"
+#include "randombytes.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ITERATIONS 2048
+#define MAXLEN 1536
+
+static const char *backend_name(unsigned backend){
+    switch(backend){
+        case AES128_BACKEND_AESNI: return "AES-NI";
+        case AES128_BACKEND_ARMV8: return "ARMv8 AES";
+        default: return "bitsliced";
+    }
+}
+
+// FIPS 197, Appendix C.1.
+static const uint8_t kat_key[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const uint8_t kat_pt[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static const uint8_t kat_ct[16] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+int main(void){
+
+    static uint8_t in[MAXLEN], a[MAXLEN], b[MAXLEN], blocks[MAXLEN + 16];
+    uint8_t key[16], iv[12], out[16];
+    aes128ctx ctx, ctx_ref;
+    aes128ctx_inline ictx, ictx_ref;
+    size_t len, nblocks;
+    int correct;
+
+    seed_rng();
+
+    printf("* AES-128 engine: %s.\n\n", backend_name(aes128_backend()));
+
+    printf("* Test AES-128 known answers.\n");
+
+    aes128_ecb_keyexp(&ctx, kat_key);
+    aes128_ecb(out, kat_pt, 1, &ctx);
+    correct = (memcmp(out, kat_ct, 16) == 0);
+    aes128_ctx_release(&ctx);
+    aes128_ecb_keyexp_ref(&ctx, kat_key);
+    aes128_ecb(out, kat_pt, 1, &ctx);
+    correct += (memcmp(out, kat_ct, 16) == 0);
+    aes128_ctx_release(&ctx);
+    aes128_ecb_keyexp_inline(&ictx, kat_key);
+    aes128_ecb_inline(out, kat_pt, 1, &ictx);
+    correct += (memcmp(out, kat_ct, 16) == 0);
+    aes128_ctx_inline_release(&ictx);
+    printf("  %d/3 correct blocks. (%s).\n\n", correct, (correct == 3)?"ok":"ERROR!");
+
+    printf("* Test the AES-128 engine against the bitsliced one.\n");
+
+    // ECB, CTR out of place and in place, and the CTR key stream of every
+    // length up to MAXLEN, through both context kinds, and CTR against ECB
+    // on explicit counter blocks.
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        len = i % MAXLEN;
+        nblocks = len / 16;
+        randombytes(key, sizeof key);
+        randombytes(iv, sizeof iv);
+        randombytes(in, len);
+
+        aes128_ctr_keyexp(&ctx, key);
+        aes128_ctr_keyexp_ref(&ctx_ref, key);
+        aes128_ctr_keyexp_inline(&ictx, key);
+        aes128_ctr_keyexp_inline_ref(&ictx_ref, key);
+
+        aes128_ecb(a, in, nblocks, &ctx);
+        aes128_ecb(b, in, nblocks, &ctx_ref);
+        correct += (memcmp(a, b, 16 * nblocks) == 0);
+
+        aes128_ctr(a, in, len, iv, &ctx);
+        aes128_ctr_inline(b, in, len, iv, &ictx_ref);
+        correct += (memcmp(a, b, len) == 0);
+
+        memcpy(b, in, len);
+        aes128_ctr_inplace_inline(b, len, iv, &ictx_ref);
+        correct += (memcmp(a, b, len) == 0);
+        memcpy(b, in, len);
+        aes128_ctr_inplace(b, len, iv, &ctx);
+        correct += (memcmp(a, b, len) == 0);
+
+        aes128_ctr_stream_inline(a, len, iv, &ictx);
+        aes128_ctr_stream(b, len, iv, &ctx_ref);
+        correct += (memcmp(a, b, len) == 0);
+
+        for(size_t j = 0; j <= nblocks; j++){
+            memcpy(blocks + 16 * j, iv, 12);
+            blocks[16 * j + 12] = (uint8_t)(j >> 24);
+            blocks[16 * j + 13] = (uint8_t)(j >> 16);
+            blocks[16 * j + 14] = (uint8_t)(j >> 8);
+            blocks[16 * j + 15] = (uint8_t)j;
+        }
+        aes128_ecb_inline(blocks, blocks, nblocks + 1, &ictx);
+        correct += (memcmp(a, blocks, len) == 0);
+
+        aes128_ctx_release(&ctx);
+        aes128_ctx_release(&ctx_ref);
+        aes128_ctx_inline_release(&ictx);
+        aes128_ctx_inline_release(&ictx_ref);
+    }
+    printf("  %d/%d identical outputs. (%s).\n\n", correct, 6 * ITERATIONS,
+        (correct == 6 * ITERATIONS)?"ok":"ERROR!");
+
+    return 0;
+
+}
@@ -1,6 +1,8 @@
 
 #include "dh_akem_api.h"
 #include "randombytes.h"
+#include "scalarmult.h"
+#include "fe.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -9,6 +11,80 @@
 
 #define ITERATIONS 2048
 
+// RFC 7748, Section 5.2: two scalar/u-coordinate pairs, then k = u = 9
+// iterated once and 1000 times.
+static const uint8_t x25519_kat[2][3][32] = {
+    {
+        {0xa5, 0x46, 0xe3, 0x6b, 0xf0, 0x52, 0x7c, 0x9d, 0x3b, 0x16, 0x15, 0x4b, 0x82, 0x46, 0x5e, 0xdd,
+         0x62, 0x14, 0x4c, 0x0a, 0xc1, 0xfc, 0x5a, 0x18, 0x50, 0x6a, 0x22, 0x44, 0xba, 0x44, 0x9a, 0xc4},
+        {0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb, 0x35, 0x94, 0xc1, 0xa4, 0x24, 0xb1, 0x5f, 0x7c,
+         0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b, 0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c},
+        {0xc3, 0xda, 0x55, 0x37, 0x9d, 0xe9, 0xc6, 0x90, 0x8e, 0x94, 0xea, 0x4d, 0xf2, 0x8d, 0x08, 0x4f,
+         0x32, 0xec, 0xcf, 0x03, 0x49, 0x1c, 0x71, 0xf7, 0x54, 0xb4, 0x07, 0x55, 0x77, 0xa2, 0x85, 0x52}
+    },
+    {
+        {0x4b, 0x66, 0xe9, 0xd4, 0xd1, 0xb4, 0x67, 0x3c, 0x5a, 0xd2, 0x26, 0x91, 0x95, 0x7d, 0x6a, 0xf5,
+         0xc1, 0x1b, 0x64, 0x21, 0xe0, 0xea, 0x01, 0xd4, 0x2c, 0xa4, 0x16, 0x9e, 0x79, 0x18, 0xba, 0x0d},
+        {0xe5, 0x21, 0x0f, 0x12, 0x78, 0x68, 0x11, 0xd3, 0xf4, 0xb7, 0x95, 0x9d, 0x05, 0x38, 0xae, 0x2c,
+         0x31, 0xdb, 0xe7, 0x10, 0x6f, 0xc0, 0x3c, 0x3e, 0xfc, 0x4c, 0xd5, 0x49, 0xc7, 0x15, 0xa4, 0x93},
+        {0x95, 0xcb, 0xde, 0x94, 0x76, 0xe8, 0x90, 0x7d, 0x7a, 0xad, 0xe4, 0x5c, 0xb4, 0xb8, 0x73, 0xf8,
+         0x8b, 0x59, 0x5a, 0x68, 0x79, 0x9f, 0xa1, 0x52, 0xe6, 0xf8, 0xf7, 0x64, 0x7a, 0xac, 0x79, 0x57}
+    }
+};
+
+static const uint8_t x25519_iterated[2][32] = {
+    {0x42, 0x2c, 0x8e, 0x7a, 0x62, 0x27, 0xd7, 0xbc, 0xa1, 0x35, 0x0b, 0x3e, 0x2b, 0xb7, 0x27, 0x9f,
+     0x78, 0x97, 0xb8, 0x7b, 0xb6, 0x85, 0x4b, 0x78, 0x3c, 0x60, 0xe8, 0x03, 0x11, 0xae, 0x30, 0x79},
+    {0x68, 0x4c, 0xf5, 0x9b, 0xa8, 0x33, 0x09, 0x55, 0x28, 0x00, 0xef, 0x56, 0x6f, 0x2f, 0x4d, 0x3c,
+     0x1c, 0x38, 0x87, 0xc4, 0x93, 0x60, 0xe3, 0x87, 0x5f, 0x2e, 0xb9, 0x4d, 0x99, 0x53, 0x2c, 0x51}
+};
+
+#if FE51_AVAILABLE
+
+// Runs the same operations through fe25 and fe51 and compares the
+// canonical encodings. Every operation except the last is applied to
+// outputs of the previous ones, so the looser fe51 limb bounds are
+// exercised too.
+static int fe_cross_check(const uint8_t a[32], const uint8_t b[32]){
+
+    fe25 f25, g25, h25, t25;
+    fe51 f51, g51, h51, t51;
+    uint8_t o25[32], o51[32];
+    int same = 1;
+
+#define FE_CROSS_CHECK(op25, op51) { \
+    op25; \
+    op51; \
+    fe25_tobytes(o25, h25); \
+    fe51_tobytes(o51, h51); \
+    same &= (memcmp(o25, o51, 32) == 0); \
+}
+
+    fe25_frombytes(f25, a);
+    fe51_frombytes(f51, a);
+    fe25_frombytes(g25, b);
+    fe51_frombytes(g51, b);
+
+    FE_CROSS_CHECK(fe25_copy(h25, f25), fe51_copy(h51, f51));
+    FE_CROSS_CHECK(fe25_add(h25, f25, g25), fe51_add(h51, f51, g51));
+    FE_CROSS_CHECK(fe25_sub(t25, f25, g25); fe25_mul(h25, h25, t25),
+                   fe51_sub(t51, f51, g51); fe51_mul(h51, h51, t51));
+    FE_CROSS_CHECK(fe25_sq(h25, h25), fe51_sq(h51, h51));
+    FE_CROSS_CHECK(fe25_mul121666(t25, h25); fe25_add(h25, t25, f25),
+                   fe51_mul121666(t51, h51); fe51_add(h51, t51, f51));
+    FE_CROSS_CHECK(fe25_sub(h25, g25, h25), fe51_sub(h51, g51, h51));
+    FE_CROSS_CHECK(fe25_mul(h25, h25, g25), fe51_mul(h51, h51, g51));
+    FE_CROSS_CHECK(fe25_cswap(h25, f25, a[0] & 1), fe51_cswap(h51, f51, a[0] & 1));
+    FE_CROSS_CHECK(fe25_invert(h25, h25), fe51_invert(h51, h51));
+
+#undef FE_CROSS_CHECK
+
+    return same;
+
+}
+
+#endif
+
 int main(void){
 
     nike_sk sender_sk, receiver_sk, attacker_sk;
@@ -21,6 +97,122 @@ int main(void){
     // initialize randombyte seed
     seed_rng();
 
+// X25519
+
+    uint8_t k[32], u[32], q[32];
+
+    correct = 0;
+    for(size_t i = 0; i < 2; i++){
+        scalarmult(q, x25519_kat[i][0], x25519_kat[i][1]);
+        correct += (memcmp(q, x25519_kat[i][2], 32) == 0);
+    }
+    memset(k, 0, 32);
+    k[0] = 9;
+    memcpy(u, k, 32);
+    for(size_t i = 1; i <= 1000; i++){
+        scalarmult(q, k, u);
+        memcpy(u, k, 32);
+        memcpy(k, q, 32);
+        if(i == 1){
+            correct += (memcmp(k, x25519_iterated[0], 32) == 0);
+        }
+    }
+    correct += (memcmp(k, x25519_iterated[1], 32) == 0);
+    printf("%d/4 X25519 known answers with the %s field arithmetic. (%s).\n\n", correct,
+        FE_RADIX51 ? "radix-2^51" : "radix-2^25.5", (correct == 4)?"ok":"ERROR!");
+
+    // The fixed-base path against the ladder on u = 9, starting with the
+    // all-zero and all-one scalars.
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        uint8_t ladder[32];
+        randombytes(k, 32);
+        if(i < 2){
+            memset(k, (i == 0) ? 0x00 : 0xff, 32);
+        }
+        scalarmult_base(q, k);
+        scalarmult_base_ladder(ladder, k);
+        correct += (memcmp(q, ladder, 32) == 0);
+    }
+    printf("%d/%d fixed-base results matching the ladder. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    // Ladders sharing one inversion against single ladders, for every
+    // count up to two chunks; every third point is u = 0, so that the
+    // point at infinity stays 0 and does not spoil the other lanes.
+    uint8_t nm[32 * 17], pm[32 * 17], qm[32 * 17];
+
+    correct = 0;
+    for(size_t count = 1; count <= 17; count++){
+        randombytes(nm, 32 * count);
+        randombytes(pm, 32 * count);
+        for(size_t i = 0; i < count; i += 3){
+            memset(pm + 32 * i, 0, 32);
+        }
+        scalarmult_many(qm, nm, pm, count);
+        for(size_t i = 0; i < count; i++){
+            scalarmult(q, nm + 32 * i, pm + 32 * i);
+            correct += (memcmp(q, qm + 32 * i, 32) == 0);
+        }
+    }
+    printf("%d/153 shared-inversion ladders matching single ladders. (%s).\n\n", correct,
+        (correct == 153)?"ok":"ERROR!");
+
+    // Four ladders at once against four single ladders, then batches of
+    // every length up to 9 against single nike_sdk calls.
+    uint8_t n4[128], p4[128], q4[128], r4[128];
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        randombytes(n4, 128);
+        randombytes(p4, 128);
+        scalarmult_x4(q4, n4, p4);
+        scalarmult_x4_ref(r4, n4, p4);
+        correct += (memcmp(q4, r4, 128) == 0);
+    }
+    printf("%d/%d four-way ladders matching single ladders. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    nike_sk batch_sk[9];
+    nike_pk batch_pk[9];
+    nike_s batch_s[9], single_s;
+
+    correct = 0;
+    for(size_t n = 0; n <= 9; n++){
+        for(size_t i = 0; i < n; i++){
+            nike_keygen(batch_sk + i, batch_pk + i);
+        }
+        nike_sdk_batch(batch_s, batch_sk, batch_pk, n);
+        for(size_t i = 0; i < n; i++){
+            nike_sdk(&single_s, batch_sk + i, batch_pk + i);
+            correct += (memcmp(&single_s, batch_s + i, sizeof(nike_s)) == 0);
+        }
+    }
+    printf("%d/45 batched shared keys matching nike_sdk. (%s).\n\n", correct,
+        (correct == 45)?"ok":"ERROR!");
+
+#if FE51_AVAILABLE
+
+    // Random elements, then encodings of 0, p - 1, p, p + 1 and 2^255 - 1.
+    uint8_t a[32], b[32];
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        randombytes(a, 32);
+        randombytes(b, 32);
+        if(i < 5){
+            memset(a, (i == 0) ? 0x00 : 0xff, 32);
+            a[31] = (i == 0) ? 0x00 : 0x7f;
+            a[0] = (uint8_t[]){0x00, 0xec, 0xed, 0xee, 0xff}[i];
+        }
+        correct += fe_cross_check(a, b);
+        correct += fe_cross_check(b, a);
+    }
+    printf("%d/%d radix-2^51 results matching radix-2^25.5. (%s).\n\n", correct, 2 * ITERATIONS,
+        (correct == 2 * ITERATIONS)?"ok":"ERROR!");
+
+#endif
+
 // NIKE AKEM
 
     correct = 0;
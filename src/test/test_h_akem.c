@@ -1,5 +1,6 @@
 
 #include "h_akem_api.h"
+#include "rsig_ctx_api.h"
 #include "randombytes.h"
 
 #include <stdio.h>
@@ -7,13 +8,77 @@
 #include <assert.h>
 
 #define ITERATIONS 2048
+// Not a multiple of the batch width, so the tail is exercised.
+#define BATCH_RECEIVERS 7
+
+static h_akem_expanded_sk expanded_sk;
+static h_akem_nk_cache sender_cache, receiver_cache;
+// More peers than cache entries, so that cycling through them evicts.
+#define CACHE_PEERS (H_AKEM_NK_CACHE_ENTRIES + 3)
+static h_akem_sk cache_sk[CACHE_PEERS];
+static h_akem_pk cache_pk[CACHE_PEERS];
+// Caller-owned contexts for the _ctx variants.
+static prng ctx_prng[2];
+static h_akem_sk ctx_sk[2];
+static h_akem_pk ctx_pk[2];
+static kem_ct ctx_ct[2];
+static rsig_signature ctx_sig[2];
+static rsig_pk ctx_ring;
+
+static int nk_cache_holds(const h_akem_nk_cache *cache, const h_akem_pk *own_pk, const h_akem_pk *peer_pk){
+    for(size_t i = 0; i < H_AKEM_NK_CACHE_ENTRIES; i++){
+        if(cache->entry[i].used &&
+           (memcmp(&cache->entry[i].own, &own_pk->npk, sizeof(nike_pk)) == 0) &&
+           (memcmp(&cache->entry[i].peer, &peer_pk->npk, sizeof(nike_pk)) == 0)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// With AKEM_HEAP_WRAP the test is linked with -Wl,--wrap for the
+// allocator, so every allocation made by the library goes through these and
+// is counted. The Makefile only sets it when the linker has --wrap (GNU ld,
+// lld); elsewhere (Apple ld64) the count is skipped.
+#ifdef AKEM_HEAP_WRAP
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static size_t heap_allocations;
+
+void *__wrap_malloc(size_t size){
+    heap_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size){
+    heap_allocations++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+    heap_allocations++;
+    return __real_realloc(ptr, size);
+}
+#endif
 
 int main(void){
 
     h_akem_sk sender_sk, receiver_sk, attacker_sk;
     h_akem_pk sender_pk, receiver_pk, attacker_pk;
     h_akem_ct ct;
+    h_akem_sk batch_sk[BATCH_RECEIVERS];
+    h_akem_pk batch_pk[BATCH_RECEIVERS];
+    h_akem_ct batch_ct[BATCH_RECEIVERS];
+    uint8_t batch_secret[BATCH_RECEIVERS][32];
+    uint8_t batch_decap_secret[BATCH_RECEIVERS][32];
+    h_akem_pk batch_claimed_pk[BATCH_RECEIVERS];
+    uint8_t batch_success[(BATCH_RECEIVERS + 7) / 8];
+    h_akem_peer_ctx sender_ctx, receiver_ctx;
     uint8_t sender_secret[32], receiver_secret[32], attacker_secret[32];
+    uint8_t ctx_secret[2][32];
+    uint64_t thread_word;
 
     int correct;
 
@@ -33,9 +98,202 @@ int main(void){
     printf("%d/%d compatible shared secret pairs. (%s).\n\n", correct, ITERATIONS,
         (correct == ITERATIONS)?"ok":"ERROR!");
 
+    // Encapsulation and decapsulation must not touch the heap.
+#ifdef AKEM_HEAP_WRAP
+    heap_allocations = 0;
+    for(size_t i = 0; i < ITERATIONS / 16; i++){
+        h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk);
+        h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk);
+    }
+    assert(heap_allocations == 0);
+    printf("%zu heap allocations in %d encapsulations and decapsulations. (%s).\n\n", heap_allocations,
+        ITERATIONS / 16, (heap_allocations == 0)?"ok":"ERROR!");
+#else
+    printf("Heap allocations not counted, the linker has no --wrap. (skipped).\n\n");
+#endif
+
     h_akem_keygen(&sender_sk, &sender_pk);
+    for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+        h_akem_keygen(batch_sk + j, batch_pk + j);
+    }
+
+    // Repeated encapsulations from one sender whose signing key is expanded once.
+    h_akem_expand_sk(&expanded_sk, &sender_sk);
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+
+        h_akem_keygen(&receiver_sk, &receiver_pk);
+        h_akem_encap_expanded_sk(sender_secret, &ct, &expanded_sk, &sender_pk, &receiver_pk);
+
+        correct += (h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk) == 1) &&
+                   (memcmp(sender_secret, receiver_secret, 32) == 0);
+        assert(correct == (i + 1));
+    }
+    printf("%d/%d compatible shared secret pairs from the expanded secret key. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    h_akem_expanded_sk_release(&expanded_sk);
+
+    // Batch decapsulation by one receiver of ciphertexts from BATCH_RECEIVERS senders.
+    // In each round one ciphertext is attributed to the wrong sender and must be rejected.
     h_akem_keygen(&receiver_sk, &receiver_pk);
 
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS / BATCH_RECEIVERS; i++){
+
+        size_t forged = i % BATCH_RECEIVERS;
+        size_t accepted;
+
+        for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+            h_akem_encap(batch_secret[j], batch_ct + j, batch_sk + j, batch_pk + j, &receiver_pk);
+            batch_claimed_pk[j] = (j == forged) ? sender_pk : batch_pk[j];
+        }
+        accepted = h_akem_decap_batch(batch_decap_secret[0], batch_success, batch_ct,
+                                     &receiver_sk, &receiver_pk, batch_claimed_pk, BATCH_RECEIVERS);
+        assert(accepted == BATCH_RECEIVERS - 1);
+        for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+            int bit = (batch_success[j / 8] >> (j % 8)) & 1;
+            if(j == forged){
+                assert(bit == 0);
+                continue;
+            }
+            correct += bit && (memcmp(batch_secret[j], batch_decap_secret[j], 32) == 0);
+        }
+        assert(correct == (i + 1) * (BATCH_RECEIVERS - 1));
+    }
+    printf("%d/%d compatible shared secret pairs from batch decapsulation. (%s).\n\n", correct,
+        (ITERATIONS / BATCH_RECEIVERS) * (BATCH_RECEIVERS - 1),
+        (correct == (ITERATIONS / BATCH_RECEIVERS) * (BATCH_RECEIVERS - 1))?"ok":"ERROR!");
+
+    h_akem_keygen(&sender_sk, &sender_pk);
+    h_akem_keygen(&receiver_sk, &receiver_pk);
+    h_akem_peer_ctx_init_sender(&sender_ctx, &sender_sk, &sender_pk, &receiver_pk);
+    h_akem_peer_ctx_init_receiver(&receiver_ctx, &receiver_sk, &receiver_pk, &sender_pk);
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+
+        if(i & 1){
+            h_akem_encap_ctx(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk, &sender_ctx);
+            correct += (h_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk) == 1) &&
+                       (memcmp(sender_secret, receiver_secret, 32) == 0);
+        }else{
+            h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk);
+            correct += (h_akem_decap_ctx(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk, &receiver_ctx) == 1) &&
+                       (memcmp(sender_secret, receiver_secret, 32) == 0);
+        }
+        assert(correct == (i + 1));
+    }
+    printf("%d/%d compatible shared secret pairs with peer contexts. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    h_akem_peer_ctx_release(&sender_ctx);
+    h_akem_peer_ctx_release(&receiver_ctx);
+
+    // Cached static-static keys, cycling through more peers than the cache
+    // holds. Every other round one side runs without the cache.
+    h_akem_nk_cache_init(&sender_cache);
+    h_akem_nk_cache_init(&receiver_cache);
+    for(size_t j = 0; j < CACHE_PEERS; j++){
+        h_akem_keygen(cache_sk + j, cache_pk + j);
+    }
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS / 4; i++){
+
+        size_t j = (i / 2) % CACHE_PEERS;
+
+        if(i & 1){
+            h_akem_encap_cached(sender_secret, &ct, &sender_sk, &sender_pk, cache_pk + j, &sender_cache);
+            correct += (h_akem_decap(receiver_secret, &ct, cache_sk + j, cache_pk + j, &sender_pk) == 1) &&
+                       (memcmp(sender_secret, receiver_secret, 32) == 0);
+        }else{
+            h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, cache_pk + j);
+            correct += (h_akem_decap_cached(receiver_secret, &ct, cache_sk + j, cache_pk + j, &sender_pk, &receiver_cache) == 1) &&
+                       (memcmp(sender_secret, receiver_secret, 32) == 0);
+        }
+        assert(correct == (i + 1));
+    }
+    printf("%d/%d compatible shared secret pairs with cached static-static keys. (%s).\n\n", correct, ITERATIONS / 4,
+        (correct == ITERATIONS / 4)?"ok":"ERROR!");
+
+    // A ciphertext attributed to the wrong sender is rejected and leaves no
+    // entry behind.
+    h_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, cache_pk);
+    correct = (h_akem_decap_cached(receiver_secret, &ct, cache_sk, cache_pk, cache_pk + 1, &receiver_cache) == 0) &&
+              !nk_cache_holds(&receiver_cache, cache_pk, cache_pk + 1);
+    assert(correct);
+    printf("%d/1 rejected ciphertexts kept out of the cache. (%s).\n\n", correct,
+        correct?"ok":"ERROR!");
+
+    // A pinned entry survives a full cycle through the other peers, and a
+    // cache whose entries are all pinned refuses to pin more but still
+    // serves encapsulations.
+    correct = h_akem_nk_cache_pin(&sender_cache, &sender_sk, &sender_pk, cache_pk);
+    for(size_t j = 1; j < CACHE_PEERS; j++){
+        h_akem_encap_cached(sender_secret, &ct, &sender_sk, &sender_pk, cache_pk + j, &sender_cache);
+    }
+    correct += nk_cache_holds(&sender_cache, &sender_pk, cache_pk);
+    for(size_t j = 1; j < H_AKEM_NK_CACHE_ENTRIES; j++){
+        correct += h_akem_nk_cache_pin(&sender_cache, &sender_sk, &sender_pk, cache_pk + j);
+    }
+    correct += !h_akem_nk_cache_pin(&sender_cache, &sender_sk, &sender_pk, cache_pk + H_AKEM_NK_CACHE_ENTRIES);
+    h_akem_encap_cached(sender_secret, &ct, &sender_sk, &sender_pk, cache_pk + H_AKEM_NK_CACHE_ENTRIES, &sender_cache);
+    correct += (h_akem_decap(receiver_secret, &ct, cache_sk + H_AKEM_NK_CACHE_ENTRIES, cache_pk + H_AKEM_NK_CACHE_ENTRIES, &sender_pk) == 1) &&
+               (memcmp(sender_secret, receiver_secret, 32) == 0);
+    for(size_t j = 0; j < H_AKEM_NK_CACHE_ENTRIES; j++){
+        h_akem_nk_cache_unpin(&sender_cache, &sender_pk, cache_pk + j);
+    }
+    correct += h_akem_nk_cache_pin(&sender_cache, &sender_sk, &sender_pk, cache_pk + H_AKEM_NK_CACHE_ENTRIES);
+    assert(correct == H_AKEM_NK_CACHE_ENTRIES + 4);
+    printf("%d/%d pinning checks. (%s).\n\n", correct, H_AKEM_NK_CACHE_ENTRIES + 4,
+        (correct == H_AKEM_NK_CACHE_ENTRIES + 4)?"ok":"ERROR!");
+
+    h_akem_nk_cache_release(&sender_cache);
+    h_akem_nk_cache_release(&receiver_cache);
+
+    correct = 0;
+    for(size_t i = 0; i < sizeof(h_akem_nk_cache); i++){
+        correct += ((const uint8_t*)&sender_cache)[i] != 0;
+        correct += ((const uint8_t*)&receiver_cache)[i] != 0;
+    }
+    assert(correct == 0);
+    printf("%d nonzero bytes in released caches. (%s).\n\n", correct,
+        (correct == 0)?"ok":"ERROR!");
+
+    // The _ctx variants draw only from the context they are given: two
+    // contexts seeded alike give the same keys, ciphertext and signature,
+    // and the thread's own context carries on where it was.
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS / 64; i++){
+
+        init_prng();
+        thread_word = get64();
+        init_prng();
+        for(size_t j = 0; j < 2; j++){
+            prng_init(ctx_prng + j, &i, sizeof i, 0);
+            nike_keygen_ctx(&ctx_sk[j].nsk, &ctx_pk[j].npk, ctx_prng + j);
+            sign_keygen_ctx(&ctx_sk[j].ssk, &ctx_pk[j].spk, ctx_prng + j);
+            kem_encap_ctx(ctx_secret[j], 32, ctx_ct + j, &receiver_pk.kpk, ctx_prng + j);
+            ctx_ring.hs[0] = ctx_pk[j].spk;
+            ctx_ring.hs[1] = receiver_pk.spk;
+            Gandalf_sign_ctx(ctx_sig + j, ctx_secret[j], 32, &ctx_ring, &ctx_sk[j].ssk, 0, ctx_prng + j);
+        }
+        correct += (memcmp(&ctx_sk[0].nsk, &ctx_sk[1].nsk, sizeof(nike_sk)) == 0) &&
+                   (memcmp(&ctx_pk[0].npk, &ctx_pk[1].npk, sizeof(nike_pk)) == 0) &&
+                   (memcmp(&ctx_sk[0].ssk, &ctx_sk[1].ssk, sizeof(sign_sk)) == 0) &&
+                   (memcmp(&ctx_pk[0].spk, &ctx_pk[1].spk, sizeof(sign_pk)) == 0) &&
+                   (memcmp(ctx_ct, ctx_ct + 1, sizeof(kem_ct)) == 0) &&
+                   (memcmp(ctx_secret[0], ctx_secret[1], 32) == 0) &&
+                   (memcmp(ctx_sig, ctx_sig + 1, sizeof(rsig_signature)) == 0) &&
+                   Gandalf_verify(ctx_secret[0], 32, ctx_sig, &ctx_ring) &&
+                   (get64() == thread_word);
+    }
+    seed_rng();
+    printf("%d/%d identical outputs from explicit PRNG contexts. (%s).\n\n", correct, ITERATIONS / 64,
+        (correct == ITERATIONS / 64)?"ok":"ERROR!");
+
     correct = 0;
     for(size_t i = 0; i < ITERATIONS; i++){
 
@@ -11,12 +11,50 @@
 #include <assert.h>
 
 #define ITERATIONS 2048
+// Not a multiple of the batch width, so the tail is exercised.
+#define BATCH_RECEIVERS 7
+
+static pq_akem_expanded_sk expanded_sk;
+
+// With AKEM_HEAP_WRAP the test is linked with -Wl,--wrap for the
+// allocator, so every allocation made by the library goes through these and
+// is counted. The Makefile only sets it when the linker has --wrap (GNU ld,
+// lld); elsewhere (Apple ld64) the count is skipped.
+#ifdef AKEM_HEAP_WRAP
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static size_t heap_allocations;
+
+void *__wrap_malloc(size_t size){
+    heap_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size){
+    heap_allocations++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+    heap_allocations++;
+    return __real_realloc(ptr, size);
+}
+#endif
 
 int main(){
 
     pq_akem_sk sender_sk, receiver_sk, attacker_sk;
     pq_akem_pk sender_pk, receiver_pk, attacker_pk;
     pq_akem_ct ct;
+    pq_akem_sk batch_sk[BATCH_RECEIVERS];
+    pq_akem_pk batch_pk[BATCH_RECEIVERS];
+    pq_akem_ct batch_ct[BATCH_RECEIVERS];
+    uint8_t batch_secret[BATCH_RECEIVERS][32];
+    uint8_t batch_decap_secret[BATCH_RECEIVERS][32];
+    pq_akem_pk batch_claimed_pk[BATCH_RECEIVERS];
+    uint8_t batch_success[(BATCH_RECEIVERS + 7) / 8];
     uint8_t sender_secret[32], receiver_secret[32], attacker_secret[32];
 
     int correct;
@@ -38,6 +76,74 @@ int main(){
     printf("%d/%d compatible shared secret pairs. (%s).\n\n", correct, ITERATIONS,
         (correct == ITERATIONS)?"ok":"ERROR!");
 
+    // Encapsulation and decapsulation must not touch the heap.
+#ifdef AKEM_HEAP_WRAP
+    heap_allocations = 0;
+    for(size_t i = 0; i < ITERATIONS / 16; i++){
+        pq_akem_encap(sender_secret, &ct, &sender_sk, &sender_pk, &receiver_pk);
+        pq_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk);
+    }
+    assert(heap_allocations == 0);
+    printf("%zu heap allocations in %d encapsulations and decapsulations. (%s).\n\n", heap_allocations,
+        ITERATIONS / 16, (heap_allocations == 0)?"ok":"ERROR!");
+#else
+    printf("Heap allocations not counted, the linker has no --wrap. (skipped).\n\n");
+#endif
+
+    pq_akem_keygen(&sender_sk, &sender_pk);
+    for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+        pq_akem_keygen(batch_sk + j, batch_pk + j);
+    }
+
+    // Repeated encapsulations from one sender whose signing key is expanded once.
+    pq_akem_expand_sk(&expanded_sk, &sender_sk);
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+
+        pq_akem_keygen(&receiver_sk, &receiver_pk);
+        pq_akem_encap_expanded_sk(sender_secret, &ct, &expanded_sk, &sender_pk, &receiver_pk);
+
+        correct += (pq_akem_decap(receiver_secret, &ct, &receiver_sk, &receiver_pk, &sender_pk) == 1) &&
+                   (memcmp(sender_secret, receiver_secret, 32) == 0);
+        assert(correct == (i + 1));
+    }
+    printf("%d/%d compatible shared secret pairs from the expanded secret key. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    pq_akem_expanded_sk_release(&expanded_sk);
+
+    // Batch decapsulation by one receiver of ciphertexts from BATCH_RECEIVERS senders.
+    // In each round one ciphertext is attributed to the wrong sender and must be rejected.
+    pq_akem_keygen(&receiver_sk, &receiver_pk);
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS / BATCH_RECEIVERS; i++){
+
+        size_t forged = i % BATCH_RECEIVERS;
+        size_t accepted;
+
+        for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+            pq_akem_encap(batch_secret[j], batch_ct + j, batch_sk + j, batch_pk + j, &receiver_pk);
+            batch_claimed_pk[j] = (j == forged) ? sender_pk : batch_pk[j];
+        }
+        accepted = pq_akem_decap_batch(batch_decap_secret[0], batch_success, batch_ct,
+                                     &receiver_sk, &receiver_pk, batch_claimed_pk, BATCH_RECEIVERS);
+        assert(accepted == BATCH_RECEIVERS - 1);
+        for(size_t j = 0; j < BATCH_RECEIVERS; j++){
+            int bit = (batch_success[j / 8] >> (j % 8)) & 1;
+            if(j == forged){
+                assert(bit == 0);
+                continue;
+            }
+            correct += bit && (memcmp(batch_secret[j], batch_decap_secret[j], 32) == 0);
+        }
+        assert(correct == (i + 1) * (BATCH_RECEIVERS - 1));
+    }
+    printf("%d/%d compatible shared secret pairs from batch decapsulation. (%s).\n\n", correct,
+        (ITERATIONS / BATCH_RECEIVERS) * (BATCH_RECEIVERS - 1),
+        (correct == (ITERATIONS / BATCH_RECEIVERS) * (BATCH_RECEIVERS - 1))?"ok":"ERROR!");
+
     pq_akem_keygen(&sender_sk, &sender_pk);
     pq_akem_keygen(&receiver_sk, &receiver_pk);
 
@@ -0,0 +1,168 @@
+
+#include "randombytes.h"
+#include "chacha20.h"
+#include "blake2.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define ITERATIONS 2048
+
+// RFC 8439, Section 2.3.2: key 00 01 ... 1f, nonce 00 00 00 09 00 00 00 4a
+// 00 00 00 00, block counter 1.
+static const uint8_t kat_rfc8439_nonce[12] = {
+    0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00
+};
+
+static const uint8_t kat_rfc8439_block[64] = {
+    0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+    0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+    0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+    0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e
+};
+
+// Key 80 81 ... 9f, nonce 07 00 ... 00 (as used for refill number 7),
+// block counter 0: the 13th block, i.e. after one 8-block pass.
+static const uint8_t kat_block12[64] = {
+    0x93, 0xf0, 0x0d, 0x86, 0xf1, 0xfe, 0xb9, 0x67, 0x92, 0x80, 0x58, 0xa5, 0xf4, 0x33, 0xc7, 0x0a,
+    0x81, 0x03, 0x7b, 0xb5, 0x07, 0x5c, 0x49, 0xaa, 0x1a, 0xf2, 0x4b, 0x42, 0x4a, 0x1a, 0x55, 0x51,
+    0x4f, 0x67, 0x1c, 0xc7, 0xf1, 0x99, 0xa8, 0xf7, 0xa3, 0xcf, 0x9a, 0x07, 0x24, 0xdf, 0xd3, 0x1a,
+    0x5f, 0x87, 0x5e, 0xe4, 0xf6, 0x51, 0x91, 0xe3, 0x17, 0xcf, 0xe7, 0x49, 0xb3, 0xf4, 0x6a, 0x3f
+};
+
+int main(void){
+
+    static uint8_t a[64 * 64], b[64 * 64];
+    static uint64_t w[1024], w_ref[1024];
+    uint8_t key[32], nonce[12], seed[48], digest[2][32];
+    uint64_t label;
+    uint32_t ctr;
+    size_t nblocks, len;
+    int correct;
+    int fd[2];
+    pid_t pid;
+
+    seed_rng();
+
+    printf("* Test ChaCha20 known answers.\n");
+
+    for(size_t i = 0; i < 32; i++){
+        key[i] = (uint8_t)i;
+    }
+    chacha20_blocks_ref(a, 1, key, kat_rfc8439_nonce, 1);
+    chacha20_blocks(b, 1, key, kat_rfc8439_nonce, 1);
+    correct = (memcmp(a, kat_rfc8439_block, 64) == 0) + (memcmp(b, kat_rfc8439_block, 64) == 0);
+
+    for(size_t i = 0; i < 32; i++){
+        key[i] = (uint8_t)(0x80 + i);
+    }
+    memset(nonce, 0, sizeof nonce);
+    nonce[0] = 7;
+    chacha20_blocks_ref(a, 13, key, nonce, 0);
+    chacha20_blocks(b, 13, key, nonce, 0);
+    correct += (memcmp(a + 12 * 64, kat_block12, 64) == 0) + (memcmp(b + 12 * 64, kat_block12, 64) == 0);
+    printf("  %d/4 correct blocks. (%s).\n\n", correct, (correct == 4)?"ok":"ERROR!");
+
+    printf("* Test chacha20_blocks against chacha20_blocks_ref.\n");
+
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        randombytes(key, sizeof key);
+        randombytes(nonce, sizeof nonce);
+        ctr = (uint32_t)get64() & 0xFFFFFF;
+        nblocks = i % 64;
+        chacha20_blocks_ref(a, nblocks, key, nonce, ctr);
+        chacha20_blocks(b, nblocks, key, nonce, ctr);
+        correct += (memcmp(a, b, 64 * nblocks) == 0);
+    }
+    printf("  %d/%d identical keystreams. (%s).\n\n", correct, ITERATIONS,
+        (correct == ITERATIONS)?"ok":"ERROR!");
+
+    printf("* Test blake2s_expand and keyed blake2s against the portable engine.\n");
+
+    // Every output length up to 64 * 64 bytes, so that blake2s_expand runs
+    // zero or more pairs of blocks and a partial tail, with seeds of 0 to 48
+    // bytes; keyed hashing covers 0 to 32-byte keys and messages of up to
+    // 64 blocks.
+    correct = 0;
+    for(size_t i = 0; i < sizeof a; i++){
+        len = 1 + i;
+        randombytes(seed, sizeof seed);
+        label = get64();
+        blake2s_expand_ref(a, len, seed, i % 49, label);
+        blake2s_expand(b, len, seed, i % 49, label);
+        correct += (memcmp(a, b, len) == 0);
+
+        randombytes(key, sizeof key);
+        randombytes(a, i);
+        blake2s_ref(digest[0], 1 + i % 32, key, i % 33, a, i);
+        blake2s(digest[1], 1 + i % 32, key, i % 33, a, i);
+        correct += (memcmp(digest[0], digest[1], 1 + i % 32) == 0);
+    }
+    printf("  %d/%d identical outputs. (%s).\n\n", correct, (int)(2 * sizeof a),
+        (correct == (int)(2 * sizeof a))?"ok":"ERROR!");
+
+    printf("* Test the PRNG interfaces against each other.\n");
+
+    // randombytes(len) is a prefix of randombytes(64 * 64) from the same
+    // state, and get64_bulk matches get64 across refills.
+    correct = 0;
+    for(size_t i = 0; i < ITERATIONS; i++){
+        len = 1 + i % (sizeof a - 1);
+        init_prng();
+        randombytes(a, len);
+        init_prng();
+        randombytes(b, sizeof b);
+        correct += (memcmp(a, b, len) == 0);
+
+        len = i % 1024;
+        init_prng();
+        for(size_t j = 0; j < i % 7; j++){
+            get8();
+        }
+        get64_bulk(w, len);
+        init_prng();
+        for(size_t j = 0; j < i % 7; j++){
+            get8();
+        }
+        for(size_t j = 0; j < len; j++){
+            w_ref[j] = get64();
+        }
+        correct += (memcmp(w, w_ref, 8 * len) == 0);
+    }
+    seed_rng();
+    printf("  %d/%d consistent outputs. (%s).\n\n", correct, 2 * ITERATIONS,
+        (correct == 2 * ITERATIONS)?"ok":"ERROR!");
+
+    printf("* Test reseeding after fork.\n");
+
+    // Parent and child draw from the context the parent was using,
+    // including bytes already buffered before the fork.
+    correct = 0;
+    for(size_t i = 0; i < 64; i++){
+        seed_rng();
+        get8();
+        if(pipe(fd) != 0 || (pid = fork()) < 0){
+            printf("  fork failed. (ERROR!).\n\n");
+            return 1;
+        }
+        if(pid == 0){
+            get64_bulk(w, 8);
+            (void)!write(fd[1], w, 64);
+            _exit(0);
+        }
+        get64_bulk(w, 8);
+        correct += (read(fd[0], w_ref, 64) == 64) && (memcmp(w, w_ref, 64) != 0);
+        waitpid(pid, NULL, 0);
+        close(fd[0]);
+        close(fd[1]);
+    }
+    printf("  %d/64 distinct parent/child outputs. (%s).\n\n", correct,
+        (correct == 64)?"ok":"ERROR!");
+
+    return 0;
+
+}